@@ -0,0 +1,313 @@
+/**
+ * @file
+ * @brief Async channel header file
+ * @authors Pavlov Ilya
+ *
+ * Contains coroutine channel with deque buffer
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Channel passing values between coroutines.
+ *
+ * Values are buffered in deque. A value pushed while a consumer waits is handed to the consumer
+ * directly. A waiting coroutine is resumed by the thread that unblocks it, after the channel lock
+ * is released.
+ * @tparam T values type
+ */
+template <typename T>
+class async_channel {
+public:
+  static constexpr size_t unbounded = SIZE_MAX;  ///< capacity of channel without limit
+
+private:
+  /**
+   * Coroutine waiting for a value
+   */
+  struct consumer_waiter {
+    std::coroutine_handle<> handle;  ///< waiting coroutine
+    std::optional<T> value;          ///< value handed to the coroutine
+  };
+
+  /**
+   * Coroutine waiting for free space
+   */
+  struct producer_waiter {
+    std::coroutine_handle<> handle;  ///< waiting coroutine
+    std::optional<T> value;          ///< value to push
+  };
+
+  mutable std::mutex mutex;            ///< guard for all the fields below
+  deque<T> buffer;                     ///< values nobody has taken yet
+  deque<consumer_waiter*> consumers;   ///< coroutines waiting for values
+  deque<producer_waiter*> producers;   ///< coroutines waiting for free space
+  size_t _capacity;                    ///< max number of buffered values
+
+  /**
+   * Take the oldest value and let one waiting producer in
+   * @param[out] out value
+   * @return producer to resume or null handle
+   */
+  std::coroutine_handle<> _take(std::optional<T>& out) {
+    if (buffer.empty()) {
+      producer_waiter* producer = producers.front();
+      producers.pop_front();
+      out.emplace(std::move(*producer->value));
+      return producer->handle;
+    }
+
+    out.emplace(std::move(buffer.front()));
+    buffer.pop_front();
+    if (producers.empty())
+      return std::coroutine_handle<>();
+
+    producer_waiter* producer = producers.front();
+    producers.pop_front();
+    buffer.push_back(std::move(*producer->value));
+    return producer->handle;
+  }
+
+  /**
+   * Take up to max values
+   * @param[out] out values
+   * @param[in] max max number of values
+   * @param[out] to_resume producers to resume
+   */
+  void _take_many(std::vector<T>& out, size_t max, std::vector<std::coroutine_handle<>>& to_resume) {
+    while (out.size() < max && !(buffer.empty() && producers.empty())) {
+      std::optional<T> value;
+      std::coroutine_handle<> producer = _take(value);
+      out.push_back(std::move(*value));
+      if (producer)
+        to_resume.push_back(producer);
+    }
+  }
+
+  /**
+   * Awaitable result of push()
+   */
+  class push_awaiter {
+  private:
+    async_channel& channel;  ///< target channel
+    producer_waiter waiter;  ///< waiter record used while suspended
+
+  public:
+    push_awaiter(async_channel& channel, T&& value) : channel(channel) {
+      waiter.value.emplace(std::move(value));
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      std::unique_lock<std::mutex> lock(channel.mutex);
+      if (!channel.consumers.empty()) {
+        consumer_waiter* consumer = channel.consumers.front();
+        channel.consumers.pop_front();
+        consumer->value.emplace(std::move(*waiter.value));
+        lock.unlock();
+        consumer->handle.resume();
+        return false;
+      }
+
+      if (channel.buffer.size() < channel._capacity) {
+        channel.buffer.push_back(std::move(*waiter.value));
+        return false;
+      }
+
+      waiter.handle = handle;
+      channel.producers.push_back(&waiter);
+      return true;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  /**
+   * Awaitable result of pop()
+   */
+  class pop_awaiter {
+  private:
+    async_channel& channel;  ///< source channel
+    consumer_waiter waiter;  ///< waiter record used while suspended
+
+  public:
+    explicit pop_awaiter(async_channel& channel) : channel(channel) {}
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      std::unique_lock<std::mutex> lock(channel.mutex);
+      if (channel.buffer.empty() && channel.producers.empty()) {
+        waiter.handle = handle;
+        channel.consumers.push_back(&waiter);
+        return true;
+      }
+
+      std::coroutine_handle<> producer = channel._take(waiter.value);
+      lock.unlock();
+      if (producer)
+        producer.resume();
+      return false;
+    }
+
+    T await_resume() {
+      return std::move(*waiter.value);
+    }
+  };
+
+  /**
+   * Awaitable result of pop_many()
+   */
+  class pop_many_awaiter {
+  private:
+    async_channel& channel;  ///< source channel
+    size_t max;              ///< max number of values
+    consumer_waiter waiter;  ///< waiter record used while suspended
+    std::vector<T> values;   ///< taken values
+
+  public:
+    pop_many_awaiter(async_channel& channel, size_t max) : channel(channel), max(max) {}
+
+    bool await_ready() const noexcept {
+      return max == 0;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      std::vector<std::coroutine_handle<>> to_resume;
+      {
+        std::lock_guard<std::mutex> lock(channel.mutex);
+        if (channel.buffer.empty() && channel.producers.empty()) {
+          waiter.handle = handle;
+          channel.consumers.push_back(&waiter);
+          return true;
+        }
+        channel._take_many(values, max, to_resume);
+      }
+
+      for (std::coroutine_handle<> producer : to_resume)
+        producer.resume();
+      return false;
+    }
+
+    std::vector<T> await_resume() {
+      if (!waiter.value)
+        return std::move(values);
+
+      // woken by direct hand-off, collect what else has been buffered meanwhile
+      values.push_back(std::move(*waiter.value));
+      std::vector<std::coroutine_handle<>> to_resume;
+      {
+        std::lock_guard<std::mutex> lock(channel.mutex);
+        channel._take_many(values, max, to_resume);
+      }
+      for (std::coroutine_handle<> producer : to_resume)
+        producer.resume();
+      return std::move(values);
+    }
+  };
+
+public:
+  /**
+   * Constructor
+   * @param[in] capacity max number of buffered values, 0 for hand-off only, unbounded by default
+   */
+  explicit async_channel(size_t capacity = unbounded) : _capacity(capacity) {}
+
+  async_channel(async_channel const&) = delete;
+  async_channel& operator=(async_channel const&) = delete;
+
+  /**
+   * Push value, waiting for free space in bounded channel
+   * @param[in] value value to push
+   * @return awaitable
+   */
+  push_awaiter push(T value) {
+    return push_awaiter(*this, std::move(value));
+  }
+
+  /**
+   * Pop the oldest value, waiting for it if channel is empty
+   * @return awaitable producing value
+   */
+  pop_awaiter pop() {
+    return pop_awaiter(*this);
+  }
+
+  /**
+   * Pop at least one and at most max values, waiting if channel is empty
+   * @param[in] max max number of values
+   * @return awaitable producing vector of values
+   */
+  pop_many_awaiter pop_many(size_t max) {
+    return pop_many_awaiter(*this, max);
+  }
+
+  /**
+   * Push value without waiting
+   * @param[in] value value to push
+   * @return false if bounded channel is full and nobody waits for value
+   */
+  bool try_push(T value) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!consumers.empty()) {
+      consumer_waiter* consumer = consumers.front();
+      consumers.pop_front();
+      consumer->value.emplace(std::move(value));
+      lock.unlock();
+      consumer->handle.resume();
+      return true;
+    }
+
+    if (buffer.size() >= _capacity)
+      return false;
+    buffer.push_back(std::move(value));
+    return true;
+  }
+
+  /**
+   * Pop value without waiting
+   * @return the oldest value or nothing if channel is empty
+   */
+  std::optional<T> try_pop() {
+    std::optional<T> value;
+    std::unique_lock<std::mutex> lock(mutex);
+    if (buffer.empty() && producers.empty())
+      return value;
+
+    std::coroutine_handle<> producer = _take(value);
+    lock.unlock();
+    if (producer)
+      producer.resume();
+    return value;
+  }
+
+  /**
+   * Get number of buffered values
+   * @return number of buffered values
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return buffer.size();
+  }
+
+  /**
+   * Get capacity of channel
+   * @return max number of buffered values
+   */
+  size_t capacity() const noexcept {
+    return _capacity;
+  }
+};
@@ -0,0 +1,329 @@
+/**
+ * @file
+ * @brief Block pool header file
+ * @authors Pavlov Ilya
+ *
+ * Contains process-wide pool of memory blocks and allocator using it
+ */
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Block pool usage statistics.
+ */
+struct block_pool_stats {
+  size_t os_allocations = 0;  ///< number of blocks taken from operator new
+  size_t os_releases = 0;     ///< number of blocks given back to operator delete
+  size_t magazine_hits = 0;   ///< number of allocations served by thread magazine
+  size_t depot_hits = 0;      ///< number of allocations served by shared depot
+  size_t bytes_in_use = 0;    ///< number of bytes allocated and not yet deallocated
+  size_t bytes_cached = 0;    ///< number of bytes kept in shared depot
+};
+
+/**
+ * @brief Process-wide pool of memory blocks.
+ *
+ * Blocks are grouped into size classes: multiples of 16 bytes up to 256 bytes and powers of two
+ * up to MAX_POOLED_BYTES. Bigger requests go straight to operator new.
+ * Every thread keeps a small magazine of free blocks per class, so a block freed by one deque is
+ * reused by the next one on the same thread without locking. Overflowing magazines spill half of
+ * their blocks to a shared depot, empty ones refill from it. Depot returns blocks to operator delete
+ * only while it keeps more bytes than watermark.
+ */
+class block_pool {
+public:
+  static constexpr size_t MAX_POOLED_BYTES = 1 << 16;  ///< max size of pooled block
+
+private:
+  static constexpr size_t SMALL_CLASS_COUNT = 16;  ///< classes of 16-byte steps up to 256 bytes
+  static constexpr size_t CLASS_COUNT = SMALL_CLASS_COUNT + 8;  ///< classes up to MAX_POOLED_BYTES
+  static constexpr size_t MAGAZINE_SIZE = 32;  ///< max number of blocks in thread magazine per class
+  static constexpr size_t DEFAULT_WATERMARK = 64 << 20;  ///< default max number of bytes kept in depot
+
+  /**
+   * Free blocks of thread
+   */
+  struct magazine {
+    void* blocks[CLASS_COUNT][MAGAZINE_SIZE];  ///< free blocks per class
+    size_t count[CLASS_COUNT] = {};            ///< number of free blocks per class
+
+    /**
+     * Destructor giving blocks of exiting thread to depot
+     */
+    ~magazine() {
+      block_pool& pool = instance();
+      for (size_t c = 0; c < CLASS_COUNT; ++c)
+        pool._spill(c, blocks[c], count[c]);
+    }
+  };
+
+  /**
+   * Shared free blocks of one class
+   */
+  struct depot {
+    std::mutex mutex;            ///< guard for blocks
+    std::vector<void*> blocks;   ///< free blocks
+  };
+
+  depot depots[CLASS_COUNT];                        ///< shared free blocks per class
+  std::atomic<size_t> watermark{ DEFAULT_WATERMARK };  ///< max number of bytes kept in depot
+  std::atomic<size_t> os_allocations{ 0 };
+  std::atomic<size_t> os_releases{ 0 };
+  std::atomic<size_t> magazine_hits{ 0 };
+  std::atomic<size_t> depot_hits{ 0 };
+  std::atomic<size_t> bytes_in_use{ 0 };
+  std::atomic<size_t> bytes_cached{ 0 };
+
+  block_pool() = default;
+
+  /**
+   * Get size class of block
+   * @param[in] bytes block size
+   * @return size class number
+   */
+  static size_t _class_of(size_t bytes) noexcept {
+    if (bytes <= 256)
+      return bytes == 0 ? 0 : (bytes + 15) / 16 - 1;
+    return SMALL_CLASS_COUNT + std::bit_width(bytes - 1) - 9;
+  }
+
+  /**
+   * Get block size of class
+   * @param[in] c size class number
+   * @return block size
+   */
+  static size_t _class_bytes(size_t c) noexcept {
+    return c < SMALL_CLASS_COUNT ? (c + 1) * 16 : (size_t)1 << (c - SMALL_CLASS_COUNT + 9);
+  }
+
+  /**
+   * Get magazine of calling thread
+   * @return reference to magazine
+   */
+  static magazine& _magazine() noexcept {
+    thread_local magazine mag;
+    return mag;
+  }
+
+  /**
+   * Move free blocks to depot, releasing ones above watermark
+   * @param[in] c size class number
+   * @param[in] blocks free blocks
+   * @param[in,out] count number of blocks, becomes zero
+   */
+  void _spill(size_t c, void** blocks, size_t& count) noexcept {
+    size_t bytes = _class_bytes(c);
+    size_t limit = watermark.load(std::memory_order_relaxed);
+    depot& d = depots[c];
+    std::lock_guard<std::mutex> lock(d.mutex);
+    for (; count > 0; --count) {
+      void* block = blocks[count - 1];
+      if (bytes_cached.load(std::memory_order_relaxed) + bytes > limit) {
+        ::operator delete(block);
+        os_releases.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      try {
+        d.blocks.push_back(block);
+      }
+      catch (...) {
+        ::operator delete(block);
+        os_releases.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      bytes_cached.fetch_add(bytes, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Move free blocks from depot to magazine
+   * @param[in] c size class number
+   * @param[in,out] mag magazine to fill
+   * @return true if at least one block was moved
+   */
+  bool _refill(size_t c, magazine& mag) noexcept {
+    depot& d = depots[c];
+    std::lock_guard<std::mutex> lock(d.mutex);
+    size_t take = d.blocks.size() < MAGAZINE_SIZE / 2 ? d.blocks.size() : MAGAZINE_SIZE / 2;
+    for (size_t k = 0; k < take; ++k) {
+      mag.blocks[c][mag.count[c]++] = d.blocks.back();
+      d.blocks.pop_back();
+    }
+    bytes_cached.fetch_sub(take * _class_bytes(c), std::memory_order_relaxed);
+    return take > 0;
+  }
+
+public:
+  block_pool(block_pool const&) = delete;
+  block_pool& operator=(block_pool const&) = delete;
+
+  /**
+   * Get process-wide pool
+   * @return reference to pool
+   */
+  static block_pool& instance() {
+    static block_pool pool;
+    return pool;
+  }
+
+  /**
+   * Allocate block
+   * @param[in] bytes block size
+   * @return pointer to block aligned as operator new result
+   */
+  void* allocate(size_t bytes) {
+    if (bytes > MAX_POOLED_BYTES) {
+      void* block = ::operator new(bytes);
+      os_allocations.fetch_add(1, std::memory_order_relaxed);
+      bytes_in_use.fetch_add(bytes, std::memory_order_relaxed);
+      return block;
+    }
+
+    size_t c = _class_of(bytes);
+    size_t size = _class_bytes(c);
+    magazine& mag = _magazine();
+    if (mag.count[c] > 0) {
+      magazine_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (_refill(c, mag)) {
+      depot_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+      void* block = ::operator new(size);
+      os_allocations.fetch_add(1, std::memory_order_relaxed);
+      bytes_in_use.fetch_add(size, std::memory_order_relaxed);
+      return block;
+    }
+
+    bytes_in_use.fetch_add(size, std::memory_order_relaxed);
+    return mag.blocks[c][--mag.count[c]];
+  }
+
+  /**
+   * Deallocate block
+   * @param[in] block pointer to block
+   * @param[in] bytes block size passed to allocate
+   */
+  void deallocate(void* block, size_t bytes) noexcept {
+    if (bytes > MAX_POOLED_BYTES) {
+      ::operator delete(block);
+      os_releases.fetch_add(1, std::memory_order_relaxed);
+      bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+      return;
+    }
+
+    size_t c = _class_of(bytes);
+    bytes_in_use.fetch_sub(_class_bytes(c), std::memory_order_relaxed);
+    magazine& mag = _magazine();
+    if (mag.count[c] == MAGAZINE_SIZE) {
+      size_t half = MAGAZINE_SIZE / 2;
+      _spill(c, mag.blocks[c] + MAGAZINE_SIZE - half, half);
+      mag.count[c] = MAGAZINE_SIZE - MAGAZINE_SIZE / 2;
+    }
+    mag.blocks[c][mag.count[c]++] = block;
+  }
+
+  /**
+   * Set max number of bytes kept in depot
+   * @param[in] bytes new watermark
+   */
+  void set_watermark(size_t bytes) noexcept {
+    watermark.store(bytes, std::memory_order_relaxed);
+  }
+
+  /**
+   * Give calling thread's free blocks to depot and release depot blocks above watermark
+   */
+  void trim() noexcept {
+    magazine& mag = _magazine();
+    for (size_t c = 0; c < CLASS_COUNT; ++c)
+      _spill(c, mag.blocks[c], mag.count[c]);
+
+    size_t limit = watermark.load(std::memory_order_relaxed);
+    for (size_t c = CLASS_COUNT; c-- > 0;) {
+      depot& d = depots[c];
+      std::lock_guard<std::mutex> lock(d.mutex);
+      while (!d.blocks.empty() && bytes_cached.load(std::memory_order_relaxed) > limit) {
+        ::operator delete(d.blocks.back());
+        d.blocks.pop_back();
+        bytes_cached.fetch_sub(_class_bytes(c), std::memory_order_relaxed);
+        os_releases.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Get usage statistics
+   * @return snapshot of counters
+   */
+  block_pool_stats stats() const noexcept {
+    block_pool_stats result;
+    result.os_allocations = os_allocations.load(std::memory_order_relaxed);
+    result.os_releases = os_releases.load(std::memory_order_relaxed);
+    result.magazine_hits = magazine_hits.load(std::memory_order_relaxed);
+    result.depot_hits = depot_hits.load(std::memory_order_relaxed);
+    result.bytes_in_use = bytes_in_use.load(std::memory_order_relaxed);
+    result.bytes_cached = bytes_cached.load(std::memory_order_relaxed);
+    return result;
+  }
+};
+
+/**
+ * @brief Allocator taking memory from process-wide block pool.
+ *
+ * Use it as deque allocator: deque<T, pool_allocator<T>>. Both fixed-size arrays and dynamic
+ * array of pointers are pooled.
+ * @tparam T type of allocated objects
+ */
+template <typename T>
+class pool_allocator {
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "pool_allocator does not support over-aligned types");
+
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  pool_allocator() noexcept = default;
+
+  template <typename U>
+  pool_allocator(pool_allocator<U> const&) noexcept {}
+
+  /**
+   * Allocate memory for objects
+   * @param[in] n number of objects
+   * @return pointer to memory
+   */
+  T* allocate(size_t n) {
+    if (n > SIZE_MAX / sizeof(T))
+      throw std::bad_array_new_length();
+    return static_cast<T*>(block_pool::instance().allocate(n * sizeof(T)));
+  }
+
+  /**
+   * Deallocate memory of objects
+   * @param[in] p pointer returned by allocate
+   * @param[in] n number of objects passed to allocate
+   */
+  void deallocate(T* p, size_t n) noexcept {
+    block_pool::instance().deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(pool_allocator<U> const&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(pool_allocator<U> const&) const noexcept {
+    return false;
+  }
+};
@@ -0,0 +1,363 @@
+/**
+ * @file
+ * @brief Compressed integer deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque of unsigned integers keeping interior fixed-size arrays delta- and bit-packed
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <array>
+#include <bit>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Deque of unsigned integers with compressed interior blocks.
+ *
+ * The first and the last blocks are plain arrays. Every full interior block is stored as its first
+ * value and bit-packed differences between neighbours, so long runs of increasing IDs or timestamps
+ * take a few bits per element. Access to an interior element decodes only its block. Blocks are
+ * decoded by a kernel specialised for the bit width, so the loop has constant shifts and masks and no
+ * branches, and compilers vectorize it with gathers where the target has them (AVX2).
+ * @tparam T unsigned integer type of elements
+ * @tparam BlockSize number of elements in block
+ */
+template <typename T = uint64_t, size_t BlockSize = 128>
+class compressed_deque {
+  static_assert(std::is_unsigned<T>::value, "compressed_deque requires unsigned integer elements");
+  static_assert(BlockSize >= 2, "block is too small");
+
+private:
+  static constexpr size_t BITS = sizeof(T) * 8;  ///< number of bits in element
+  static constexpr size_t WORD_BITS = 64;         ///< number of bits in packed word
+
+  /**
+   * Delta- and bit-packed full block
+   */
+  struct packed_block {
+    T base = 0;                   ///< the first value of block
+    unsigned width = 0;           ///< number of bits per difference
+    std::vector<uint64_t> words;  ///< packed differences between neighbour values and one padding word
+  };
+
+  std::vector<T> head;          ///< uncompressed first block
+  size_t head_pos = 0;          ///< index of the first element in head
+  deque<packed_block> middle;   ///< compressed interior blocks
+  std::vector<T> tail;          ///< uncompressed last block, shorter than BlockSize
+
+  /**
+   * Compress full block
+   * @param[in] values BlockSize values
+   * @return packed block
+   */
+  static packed_block _pack(T const* values) {
+    packed_block block;
+    block.base = values[0];
+
+    T all = 0;
+    for (size_t k = 1; k < BlockSize; ++k)
+      all |= (T)(values[k] - values[k - 1]);
+    block.width = (unsigned)std::bit_width(all);
+    // padding word lets decoding always read two words
+    block.words.assign(((BlockSize - 1) * block.width + WORD_BITS - 1) / WORD_BITS + 1, 0);
+
+    for (size_t k = 1; k < BlockSize; ++k) {
+      uint64_t delta = (T)(values[k] - values[k - 1]);
+      size_t pos = (k - 1) * block.width;
+      size_t word = pos / WORD_BITS;
+      size_t off = pos % WORD_BITS;
+      if (block.width == 0)
+        continue;
+      block.words[word] |= delta << off;
+      if (off + block.width > WORD_BITS)
+        block.words[word + 1] |= delta >> (WORD_BITS - off);
+    }
+    return block;
+  }
+
+  /**
+   * Get bits of packed words starting at position
+   * @param[in] words packed words with padding
+   * @param[in] pos bit position
+   * @return 64 bits starting at position
+   */
+  static uint64_t _bits_at(uint64_t const* words, int64_t pos) noexcept {
+    int64_t word = pos / (int64_t)WORD_BITS;
+    int64_t off = pos % (int64_t)WORD_BITS;
+    // two shifts instead of one by 64 - off, which is undefined for off == 0
+    return (words[word] >> off) | ((words[word + 1] << 1) << (WORD_BITS - 1 - off));
+  }
+
+  /**
+   * Decode all differences of block with known width
+   * @tparam Width number of bits per difference
+   * @param[in] words packed words with padding
+   * @param[out] out BlockSize - 1 differences
+   */
+  template <unsigned Width>
+  static void _unpack_deltas(uint64_t const* __restrict words, T* __restrict out) noexcept {
+    if constexpr (Width == 0) {
+      for (size_t k = 0; k + 1 < BlockSize; ++k)
+        out[k] = 0;
+      return;
+    }
+
+    constexpr uint64_t MASK = Width == WORD_BITS ? ~(uint64_t)0 : (((uint64_t)1 << Width) - 1);
+    // signed index of machine word size: the form compilers turn into gather loads
+    for (int64_t k = 0; k < (int64_t)BlockSize - 1; ++k)
+      out[k] = (T)(_bits_at(words, k * (int64_t)Width) & MASK);
+  }
+
+  using unpack_kernel = void (*)(uint64_t const*, T*) noexcept;
+
+  /**
+   * Make table of decoding kernels indexed by width
+   * @return table of kernels
+   */
+  template <size_t... Widths>
+  static constexpr std::array<unpack_kernel, BITS + 1> _make_kernels(std::index_sequence<Widths...>) noexcept {
+    return { &_unpack_deltas<(unsigned)Widths>... };
+  }
+
+  /**
+   * Get decoding kernel for width
+   * @param[in] width number of bits per difference
+   * @return kernel
+   */
+  static unpack_kernel _kernel(unsigned width) noexcept {
+    static constexpr std::array<unpack_kernel, BITS + 1> kernels = _make_kernels(std::make_index_sequence<BITS + 1>());
+    return kernels[width];
+  }
+
+  /**
+   * Get difference between values of block
+   * @param[in] block packed block
+   * @param[in] k index of difference, value[k + 1] - value[k]
+   * @return difference
+   */
+  static T _delta(packed_block const& block, size_t k) noexcept {
+    if (block.width == 0)
+      return 0;
+
+    uint64_t value = _bits_at(block.words.data(), (int64_t)(k * block.width));
+    return (T)(block.width == WORD_BITS ? value : value & (((uint64_t)1 << block.width) - 1));
+  }
+
+  /**
+   * Decompress block
+   * @param[in] block packed block
+   * @param[out] out BlockSize values
+   */
+  static void _unpack(packed_block const& block, T* out) noexcept {
+    // unpacking and prefix sum are separate loops, so the first one has no carried dependency
+    out[0] = block.base;
+    _kernel(block.width)(block.words.data(), out + 1);
+    for (size_t k = 1; k < BlockSize; ++k)
+      out[k] += out[k - 1];
+  }
+
+  /**
+   * Refill head after its last element was removed
+   */
+  void _refill_head() {
+    if (head_pos < head.size())
+      return;
+
+    head_pos = 0;
+    if (!middle.empty()) {
+      head.resize(BlockSize);
+      _unpack(middle.front(), head.data());
+      middle.pop_front();
+    }
+    else {
+      head.swap(tail);
+      tail.clear();
+    }
+  }
+
+public:
+  /**
+   * Constructor of empty deque
+   */
+  compressed_deque() = default;
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return element at this position
+   * @warning does not throw out of range exception
+   */
+  T operator[](size_t pos) const noexcept {
+    size_t head_size = head.size() - head_pos;
+    if (pos < head_size)
+      return head[head_pos + pos];
+
+    pos -= head_size;
+    if (pos < middle.size() * BlockSize) {
+      packed_block const& block = middle[pos / BlockSize];
+      T value = block.base;
+      for (size_t k = 0; k < pos % BlockSize; ++k)
+        value += _delta(block, k);
+      return value;
+    }
+
+    return tail[pos - middle.size() * BlockSize];
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return element at this position
+   */
+  T at(size_t pos) const {
+    if (pos >= size())
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get the first element of deque
+   * @return the first element of deque
+   */
+  T front() const noexcept {
+    return head[head_pos];
+  }
+
+  /**
+   * Get last element of deque
+   * @return the last element of deque
+   */
+  T back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return head_pos == head.size();
+  }
+
+  /**
+   * Get number of elements in deque
+   * @return number of elements in deque
+   */
+  size_t size() const noexcept {
+    return head.size() - head_pos + middle.size() * BlockSize + tail.size();
+  }
+
+  /**
+   * Get approximate number of bytes used by elements
+   * @return number of bytes
+   */
+  size_t memory_usage() const noexcept {
+    size_t bytes = (head.capacity() + tail.capacity()) * sizeof(T);
+    for (size_t k = 0; k < middle.size(); ++k)
+      bytes += sizeof(packed_block) + middle[k].words.capacity() * sizeof(T);
+    return bytes;
+  }
+
+  /**
+   * Call function for every element from the first to the last, decoding every block once
+   * @param[in] f function taking element
+   */
+  template <typename Function>
+  void for_each(Function f) const {
+    for (size_t k = head_pos; k < head.size(); ++k)
+      f(head[k]);
+
+    T buf[BlockSize];
+    for (size_t b = 0; b < middle.size(); ++b) {
+      _unpack(middle[b], buf);
+      for (size_t k = 0; k < BlockSize; ++k)
+        f(buf[k]);
+    }
+
+    for (T value : tail)
+      f(value);
+  }
+
+  /**
+   * Add element to the end of deque
+   * pram[in] value element to add
+   */
+  void push_back(T value) {
+    if (middle.empty() && tail.empty() && head.size() < BlockSize) {
+      head.push_back(value);
+      return;
+    }
+
+    if (tail.capacity() < BlockSize)
+      tail.reserve(BlockSize);
+    tail.push_back(value);
+    if (tail.size() == BlockSize) {
+      middle.push_back(_pack(tail.data()));
+      tail.clear();
+    }
+  }
+
+  /**
+   * Add element to the front of deque
+   * pram[in] value element to add
+   */
+  void push_front(T value) {
+    if (head_pos > 0) {
+      head[--head_pos] = value;
+      return;
+    }
+
+    if (head.size() == BlockSize)
+      middle.push_front(_pack(head.data()));
+    else
+      head.swap(tail);  // head is not full only when it is the only block, it becomes the last one
+
+    head.assign(BlockSize, 0);
+    head_pos = BlockSize - 1;
+    head[head_pos] = value;
+  }
+
+  /**
+   * Remove element from the front of deque
+   */
+  void pop_front() {
+    ++head_pos;
+    _refill_head();
+  }
+
+  /**
+   * Remove element from the back of deque
+   */
+  void pop_back() {
+    if (!tail.empty()) {
+      tail.pop_back();
+      return;
+    }
+
+    if (!middle.empty()) {
+      tail.resize(BlockSize);
+      _unpack(middle.back(), tail.data());
+      middle.pop_back();
+      tail.pop_back();
+      return;
+    }
+
+    head.pop_back();
+    _refill_head();
+  }
+
+  /**
+   * Remove all elements
+   */
+  void clear() {
+    head.clear();
+    head_pos = 0;
+    middle.clear();
+    tail.clear();
+  }
+};
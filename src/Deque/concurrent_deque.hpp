@@ -0,0 +1,538 @@
+/**
+ * @file
+ * @brief Concurrent deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains single-writer deque with wait-free snapshot readers and epoch-based reclamation
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Single-writer multi-reader deque.
+ *
+ * One thread calls push/pop, any number of registered readers take snapshots concurrently.
+ * Positions of elements are counted from the beginning of the current dynamic array of fixed-size
+ * arrays (state). Range of positions is packed into one atomic word of the state, so a reader sees
+ * dynamic array and cursors consistent after two loads, without locks or retries. When the dynamic
+ * array runs out of room, the writer publishes a new state and retires the old one.
+ *
+ * Readers announce the epoch they entered in their slot. Retired states and fixed-size arrays are
+ * freed once every active reader entered after the retirement. Popped elements are not destroyed
+ * until no reader can see them: pushing into a position that was popped since the last
+ * synchronize() waits for readers, so the writer blocks only when it alternates pops and pushes
+ * at the same end.
+ * @tparam T elements type
+ * @tparam BlockSize number of elements in fixed-size array
+ */
+template <typename T, size_t BlockSize = 64>
+class concurrent_deque {
+public:
+  static constexpr size_t MAX_READERS = 64;  ///< max number of registered readers
+
+private:
+  static constexpr size_t START_MAP_SIZE = 8;  ///< number of fixed-size arrays in the first state
+
+  using alloc_traits = std::allocator_traits<std::allocator<T>>;
+
+  /**
+   * Dynamic array with range of elements visible to readers
+   */
+  struct state {
+    T** map = nullptr;                ///< dynamic array of fixed-size arrays
+    size_t map_size = 0;              ///< size of dynamic array
+    std::atomic<uint64_t> range{ 0 };  ///< position of the first element | position after the last << 32
+  };
+
+  /**
+   * Object waiting for readers to leave before freeing
+   */
+  struct retired {
+    uint64_t epoch = 0;        ///< global epoch at retirement
+    state* old_state = nullptr;  ///< retired state or nullptr
+    T* block = nullptr;        ///< retired fixed-size array or nullptr
+    size_t lo = 0;             ///< index of the first constructed element in block
+  };
+
+  /**
+   * Reader announcement, one per cache line
+   */
+  struct alignas(64) reader_slot {
+    std::atomic<uint64_t> epoch{ 0 };   ///< epoch the reader entered, 0 if it does not read
+    std::atomic<bool> taken{ false };  ///< slot is registered
+  };
+
+  mutable reader_slot slots[MAX_READERS];   ///< reader announcements
+  std::atomic<uint64_t> global_epoch{ 1 };  ///< current epoch
+  std::atomic<state*> current{ nullptr };   ///< published state
+
+  // writer-only fields
+  size_t first = 0;        ///< position of the first element
+  size_t last = 0;         ///< position after the last element
+  size_t valid_lo = 0;     ///< position of the first constructed element (popped ones included)
+  size_t valid_hi = 0;     ///< position after the last constructed element (popped ones included)
+  size_t blocks_lo = 0;    ///< index of the first allocated fixed-size array
+  size_t blocks_hi = 0;    ///< index after the last allocated fixed-size array
+  size_t vacated_lo = 0;   ///< dynamic array slots in [vacated_lo, blocks_lo) were retired since synchronize()
+  std::vector<retired> retired_list;  ///< objects waiting for readers
+  std::allocator<T> alloc;            ///< allocator for fixed-size arrays
+
+  /**
+   * Pack range of positions
+   * @param[in] lo position of the first element
+   * @param[in] hi position after the last element
+   * @return packed range
+   */
+  static uint64_t _pack(size_t lo, size_t hi) noexcept {
+    return (uint64_t)lo | ((uint64_t)hi << 32);
+  }
+
+  /**
+   * Publish writer range to readers
+   */
+  void _publish() noexcept {
+    current.load(std::memory_order_relaxed)->range.store(_pack(first, last), std::memory_order_release);
+  }
+
+  /**
+   * Get element slot by position in current state
+   * @param[in] pos position
+   * @return pointer to slot
+   */
+  T* _slot(size_t pos) const noexcept {
+    return current.load(std::memory_order_relaxed)->map[pos / BlockSize] + pos % BlockSize;
+  }
+
+  /**
+   * Put object to retired list
+   * @param[in] r object to retire
+   */
+  void _retire(retired r) {
+    r.epoch = global_epoch.fetch_add(1, std::memory_order_acq_rel);
+    try {
+      retired_list.push_back(r);
+    }
+    catch (...) {
+      synchronize();
+      _free(r);
+      throw;
+    }
+  }
+
+  /**
+   * Free retired object
+   * @param[in] r retired object
+   */
+  void _free(retired const& r) noexcept {
+    if (r.old_state != nullptr) {
+      delete[] r.old_state->map;
+      delete r.old_state;
+    }
+    if (r.block != nullptr) {
+      for (size_t j = r.lo; j < BlockSize; ++j)
+        alloc_traits::destroy(alloc, r.block + j);
+      alloc_traits::deallocate(alloc, r.block, BlockSize);
+    }
+  }
+
+  /**
+   * Get the oldest epoch of active readers
+   * @return the oldest epoch or UINT64_MAX if no reader is active
+   */
+  uint64_t _oldest_reader() const noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = UINT64_MAX;
+    for (size_t k = 0; k < MAX_READERS; ++k) {
+      uint64_t e = slots[k].epoch.load(std::memory_order_acquire);
+      if (e != 0 && e < oldest)
+        oldest = e;
+    }
+    return oldest;
+  }
+
+  /**
+   * Free retired objects no reader can see, without waiting
+   */
+  void _reclaim() noexcept {
+    if (retired_list.empty())
+      return;
+
+    uint64_t oldest = _oldest_reader();
+    size_t kept = 0;
+    for (size_t k = 0; k < retired_list.size(); ++k) {
+      if (retired_list[k].epoch < oldest)
+        _free(retired_list[k]);
+      else
+        retired_list[kept++] = retired_list[k];
+    }
+    retired_list.resize(kept);
+  }
+
+  /**
+   * Replace dynamic array with a new one having free slots on both sides
+   */
+  void _relocate() {
+    state* old = current.load(std::memory_order_relaxed);
+    size_t used = blocks_hi - blocks_lo;
+    size_t map_size = 2 * used + START_MAP_SIZE;
+    if (map_size >= (size_t(1) << 32) / BlockSize)
+      throw std::length_error("concurrent_deque is too long");
+
+    state* s = new state;
+    try {
+      s->map = new T*[map_size]();
+    }
+    catch (...) {
+      delete s;
+      throw;
+    }
+    s->map_size = map_size;
+    size_t new_lo = (map_size - used) / 2;
+    for (size_t i = 0; i < used; ++i)
+      s->map[new_lo + i] = old->map[blocks_lo + i];
+
+    size_t shift = (new_lo - blocks_lo) * BlockSize;  // wraps if dynamic array moves to the left
+    first += shift;
+    last += shift;
+    valid_lo += shift;
+    valid_hi += shift;
+    blocks_hi = new_lo + used;
+    blocks_lo = new_lo;
+    vacated_lo = new_lo;
+
+    s->range.store(_pack(first, last), std::memory_order_relaxed);
+    current.store(s, std::memory_order_release);
+    retired r;
+    r.old_state = old;
+    _retire(r);
+  }
+
+public:
+  /**
+   * @brief Consistent view of deque taken by reader.
+   *
+   * Elements of snapshot stay alive and unchanged until snapshot is destroyed.
+   */
+  class snapshot {
+    friend class concurrent_deque;
+
+  private:
+    reader_slot* slot;  ///< announcement of reader
+    state* s;           ///< state seen by reader
+    size_t lo;          ///< position of the first element
+    size_t hi;          ///< position after the last element
+
+    /**
+     * Enter epoch and load state
+     * @param[in] owner deque to read
+     * @param[in] slot announcement of reader
+     */
+    snapshot(concurrent_deque const& owner, reader_slot* slot) noexcept : slot(slot) {
+      slot->epoch.store(owner.global_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      s = owner.current.load(std::memory_order_acquire);
+      uint64_t range = s->range.load(std::memory_order_acquire);
+      lo = (size_t)(uint32_t)range;
+      hi = (size_t)(range >> 32);
+    }
+
+  public:
+    snapshot(snapshot const&) = delete;
+    snapshot& operator=(snapshot const&) = delete;
+
+    /**
+     * Get element by number of position
+     * param[in] pos number of position
+     * @return const reference to element
+     * @warning does not throw out of range exception
+     */
+    T const& operator[](size_t pos) const noexcept {
+      size_t p = lo + pos;
+      return s->map[p / BlockSize][p % BlockSize];
+    }
+
+    /**
+     * Get the first element
+     * @return const reference to the first element
+     */
+    T const& front() const noexcept {
+      return (*this)[0];
+    }
+
+    /**
+     * Get last element
+     * @return const reference to the last element
+     */
+    T const& back() const noexcept {
+      return (*this)[hi - lo - 1];
+    }
+
+    /**
+     * Get number of elements
+     * @return number of elements
+     */
+    size_t size() const noexcept {
+      return hi - lo;
+    }
+
+    /**
+     * Check if snapshot is empty
+     * @return true if snapshot is empty else false
+     */
+    bool empty() const noexcept {
+      return hi == lo;
+    }
+
+    /**
+     * Call function for every element fixed-size array by fixed-size array
+     * @param[in] f function taking const reference to element
+     */
+    template <typename Function>
+    void for_each(Function f) const {
+      for (size_t p = lo; p < hi;) {
+        T const* block = s->map[p / BlockSize];
+        size_t end = (p / BlockSize + 1) * BlockSize;
+        end = end < hi ? end : hi;
+        for (; p < end; ++p)
+          f(block[p % BlockSize]);
+      }
+    }
+
+    /**
+     * Leave epoch
+     */
+    ~snapshot() {
+      slot->epoch.store(0, std::memory_order_release);
+    }
+  };
+
+  /**
+   * @brief Registered reader.
+   *
+   * Reader is used by one thread at a time and has at most one snapshot at a time.
+   */
+  class reader {
+    friend class concurrent_deque;
+
+  private:
+    concurrent_deque const* owner;  ///< deque to read
+    reader_slot* slot;              ///< announcement of reader
+
+    reader(concurrent_deque const* owner, reader_slot* slot) noexcept : owner(owner), slot(slot) {}
+
+  public:
+    reader(reader&& other) noexcept : owner(other.owner), slot(other.slot) {
+      other.slot = nullptr;
+    }
+
+    reader(reader const&) = delete;
+    reader& operator=(reader const&) = delete;
+    reader& operator=(reader&&) = delete;
+
+    /**
+     * Take snapshot of deque, wait-free
+     * @return snapshot
+     */
+    snapshot read() const noexcept {
+      return snapshot(*owner, slot);
+    }
+
+    /**
+     * Unregister reader
+     */
+    ~reader() {
+      if (slot != nullptr)
+        slot->taken.store(false, std::memory_order_release);
+    }
+  };
+
+  /**
+   * Constructor of empty deque
+   */
+  concurrent_deque() {
+    state* s = new state;
+    try {
+      s->map = new T*[START_MAP_SIZE]();
+    }
+    catch (...) {
+      delete s;
+      throw;
+    }
+    s->map_size = START_MAP_SIZE;
+    first = last = valid_lo = valid_hi = START_MAP_SIZE / 2 * BlockSize;
+    blocks_lo = blocks_hi = vacated_lo = START_MAP_SIZE / 2;
+    s->range.store(_pack(first, last), std::memory_order_relaxed);
+    current.store(s, std::memory_order_release);
+  }
+
+  concurrent_deque(concurrent_deque const&) = delete;
+  concurrent_deque& operator=(concurrent_deque const&) = delete;
+
+  /**
+   * Register reader
+   * @return reader
+   */
+  reader make_reader() const {
+    for (size_t k = 0; k < MAX_READERS; ++k) {
+      bool expected = false;
+      if (slots[k].taken.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        return reader(this, &slots[k]);
+    }
+    throw std::runtime_error("too many concurrent_deque readers");
+  }
+
+  /**
+   * Get number of elements, writer only
+   * @return number of elements
+   */
+  size_t size() const noexcept {
+    return last - first;
+  }
+
+  /**
+   * Check if deque is empty, writer only
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return last == first;
+  }
+
+  /**
+   * Get element by number of position, writer only
+   * param[in] pos number of position
+   * @return const reference to element
+   */
+  T const& operator[](size_t pos) const noexcept {
+    return *_slot(first + pos);
+  }
+
+  /**
+   * Wait until no reader sees popped elements or retired objects, then destroy and free them
+   */
+  void synchronize() noexcept {
+    uint64_t target = global_epoch.fetch_add(1, std::memory_order_acq_rel);
+    while (_oldest_reader() <= target)
+      std::this_thread::yield();
+
+    for (size_t p = valid_lo; p < first; ++p)
+      alloc_traits::destroy(alloc, _slot(p));
+    for (size_t p = last; p < valid_hi; ++p)
+      alloc_traits::destroy(alloc, _slot(p));
+    valid_lo = first;
+    valid_hi = last;
+
+    for (size_t k = 0; k < retired_list.size(); ++k)
+      _free(retired_list[k]);
+    retired_list.clear();
+    vacated_lo = blocks_lo;
+  }
+
+  /**
+   * Add element to the end of deque
+   * pram[in] value element to add
+   */
+  void push_back(T const& value) {
+    if (last < valid_hi)
+      synchronize();
+
+    state* s = current.load(std::memory_order_relaxed);
+    if (last / BlockSize >= s->map_size) {
+      _relocate();
+      s = current.load(std::memory_order_relaxed);
+    }
+
+    size_t b = last / BlockSize;
+    if (b >= blocks_hi) {
+      s->map[b] = alloc_traits::allocate(alloc, BlockSize);
+      blocks_hi = b + 1;
+    }
+
+    alloc_traits::construct(alloc, s->map[b] + last % BlockSize, value);
+    ++last;
+    valid_hi = last;
+    _publish();
+  }
+
+  /**
+   * Add element to the front of deque
+   * pram[in] value element to add
+   */
+  void push_front(T const& value) {
+    if (first > valid_lo)
+      synchronize();
+
+    state* s = current.load(std::memory_order_relaxed);
+    if (first == 0) {
+      _relocate();
+      s = current.load(std::memory_order_relaxed);
+    }
+
+    size_t b = (first - 1) / BlockSize;
+    if (b < blocks_lo) {
+      if (b >= vacated_lo)
+        synchronize();
+      s->map[b] = alloc_traits::allocate(alloc, BlockSize);
+      blocks_lo = b;
+      vacated_lo = b;
+    }
+
+    alloc_traits::construct(alloc, s->map[b] + (first - 1) % BlockSize, value);
+    --first;
+    valid_lo = first;
+    _publish();
+  }
+
+  /**
+   * Remove element from the back of deque
+   */
+  void pop_back() noexcept {
+    --last;
+    _publish();
+  }
+
+  /**
+   * Remove element from the front of deque
+   */
+  void pop_front() {
+    ++first;
+    _publish();
+
+    if (first / BlockSize > blocks_lo) {
+      state* s = current.load(std::memory_order_relaxed);
+      while (blocks_lo < first / BlockSize) {
+        retired r;
+        r.block = s->map[blocks_lo];
+        r.lo = valid_lo > blocks_lo * BlockSize ? valid_lo - blocks_lo * BlockSize : 0;
+        r.lo = r.lo < BlockSize ? r.lo : BlockSize;
+        ++blocks_lo;
+        valid_lo = valid_lo > blocks_lo * BlockSize ? valid_lo : blocks_lo * BlockSize;
+        _retire(r);
+      }
+      _reclaim();
+    }
+  }
+
+  /**
+   * Just destructor
+   * @warning all readers must be destroyed before
+   */
+  ~concurrent_deque() {
+    synchronize();
+    state* s = current.load(std::memory_order_relaxed);
+    for (size_t p = first; p < last; ++p)
+      alloc_traits::destroy(alloc, _slot(p));
+    for (size_t b = blocks_lo; b < blocks_hi; ++b)
+      alloc_traits::deallocate(alloc, s->map[b], BlockSize);
+    delete[] s->map;
+    delete s;
+  }
+};
@@ -0,0 +1,285 @@
+/**
+ * @file
+ * @brief Copy-on-write deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque with reference-counted fixed-size arrays shared between copies
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <new>
+
+/**
+ * @brief Copy-on-write deque class.
+ *
+ * Copy shares all fixed-size arrays (blocks) with the original, so it costs O(number of blocks).
+ * Push, pop or element modification duplicates only the touched block if it is shared.
+ * Popping from a shared block does not copy it, the popped element just leaves this deque's view.
+ * @tparam T deque elements type
+ * @tparam BlockSize number of elements in block
+ */
+template <typename T, size_t BlockSize = 64>
+class cow_deque {
+private:
+  /**
+   * Fixed-size array with range of constructed elements
+   */
+  struct block {
+    size_t begin = 0;  ///< index of the first constructed element
+    size_t end = 0;    ///< index after the last constructed element
+    alignas(T) unsigned char storage[BlockSize * sizeof(T)];  ///< raw memory for elements
+
+    /**
+     * Constructor of empty block
+     * @param[in] pos index to start constructing elements from
+     */
+    explicit block(size_t pos) noexcept : begin(pos), end(pos) {}
+
+    /**
+     * Constructor copying part of other block
+     * @param[in] other block to copy from
+     * @param[in] lo index of the first element to copy
+     * @param[in] hi index after the last element to copy
+     */
+    block(block const& other, size_t lo, size_t hi) : begin(lo), end(lo) {
+      for (; end < hi; ++end)
+        ::new (static_cast<void*>(slot(end))) T(*other.slot(end));
+    }
+
+    block(block const&) = delete;
+    block& operator=(block const&) = delete;
+
+    /**
+     * Get element slot
+     * @param[in] j index in block
+     * @return pointer to slot
+     */
+    T* slot(size_t j) noexcept {
+      return std::launder(reinterpret_cast<T*>(storage) + j);
+    }
+
+    /**
+     * Get element slot
+     * @param[in] j index in block
+     * @return pointer to slot
+     */
+    T const* slot(size_t j) const noexcept {
+      return std::launder(reinterpret_cast<T const*>(storage) + j);
+    }
+
+    /**
+     * Destroy constructed elements out of range
+     * @param[in] lo index of the first element to keep
+     * @param[in] hi index after the last element to keep
+     */
+    void trim(size_t lo, size_t hi) noexcept {
+      for (; begin < lo; ++begin)
+        slot(begin)->~T();
+      for (; end > hi; --end)
+        slot(end - 1)->~T();
+    }
+
+    /**
+     * Just destructor
+     */
+    ~block() {
+      trim(end, end);
+    }
+  };
+
+  deque<std::shared_ptr<block>> blocks;  ///< blocks covering elements of this deque
+  size_t first = 0;                      ///< index of the first element in the first block
+  size_t _size = 0;                      ///< number of elements in deque
+
+  /**
+   * Make block owned only by this deque with exactly this deque's elements constructed
+   * @param[in] k block number
+   * @return reference to block
+   */
+  block& _own(size_t k) {
+    size_t lo = k == 0 ? first : 0;
+    size_t hi = first + _size - k * BlockSize;
+    hi = hi < BlockSize ? hi : BlockSize;
+
+    std::shared_ptr<block>& b = blocks[k];
+    if (b.use_count() > 1)
+      b = std::make_shared<block>(*b, lo, hi);
+    else
+      b->trim(lo, hi);
+    return *b;
+  }
+
+  /**
+   * Forget all blocks after the last element was removed
+   */
+  void _reset_if_empty() {
+    if (_size != 0)
+      return;
+    blocks.clear();
+    first = 0;
+  }
+
+public:
+  /**
+   * Constructor of empty deque
+   */
+  cow_deque() = default;
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return const reference to element at this position
+   * @warning does not throw out of range exception
+   */
+  T const& operator[](size_t pos) const noexcept {
+    size_t p = first + pos;
+    return *blocks[p / BlockSize]->slot(p % BlockSize);
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return const reference to element at this position
+   */
+  T const& at(size_t pos) const {
+    if (pos >= _size)
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get element for modification, copying its block if it is shared
+   * param[in] pos number of position
+   * @return reference to element at this position
+   */
+  T& modify(size_t pos) {
+    if (pos >= _size)
+      throw std::out_of_range("index out of range");
+
+    size_t p = first + pos;
+    return *_own(p / BlockSize).slot(p % BlockSize);
+  }
+
+  /**
+   * Get the first element of deque
+   * @return const reference to the first element of deque
+   */
+  T const& front() const noexcept {
+    return (*this)[0];
+  }
+
+  /**
+   * Get last element of deque
+   * @return const reference to the last element of deque
+   */
+  T const& back() const noexcept {
+    return (*this)[_size - 1];
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  /**
+   * Get number of elements in deque
+   * @return number of elements in deque
+   */
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  /**
+   * Get number of blocks shared with other deques
+   * @return number of shared blocks
+   */
+  size_t shared_blocks() const noexcept {
+    size_t count = 0;
+    for (size_t k = 0; k < blocks.size(); ++k)
+      count += blocks[k].use_count() > 1;
+    return count;
+  }
+
+  /**
+   * Add element to the end of deque
+   * pram[in] value element to add
+   */
+  void push_back(T const& value) {
+    size_t p = first + _size;
+    size_t k = p / BlockSize;
+    if (k == blocks.size())
+      blocks.push_back(std::make_shared<block>(0));
+
+    block& b = _own(k);
+    ::new (static_cast<void*>(b.slot(b.end))) T(value);
+    ++b.end;
+    ++_size;
+  }
+
+  /**
+   * Add element to the front of deque
+   * pram[in] value element to add
+   */
+  void push_front(T const& value) {
+    if (first == 0) {
+      blocks.push_front(std::make_shared<block>(BlockSize));
+      first = BlockSize;
+    }
+
+    block& b = _own(0);
+    ::new (static_cast<void*>(b.slot(b.begin - 1))) T(value);
+    --b.begin;
+    --first;
+    ++_size;
+  }
+
+  /**
+   * Remove element from the back of deque
+   */
+  void pop_back() {
+    size_t p = first + _size - 1;
+    size_t k = p / BlockSize;
+    if (blocks[k].use_count() == 1) {
+      block& b = _own(k);
+      b.trim(b.begin, b.end - 1);
+    }
+
+    --_size;
+    if (p % BlockSize == 0)
+      blocks.pop_back();
+    _reset_if_empty();
+  }
+
+  /**
+   * Remove element from the front of deque
+   */
+  void pop_front() {
+    if (blocks[0].use_count() == 1) {
+      block& b = _own(0);
+      b.trim(b.begin + 1, b.end);
+    }
+
+    ++first;
+    --_size;
+    if (first == BlockSize) {
+      blocks.pop_front();
+      first = 0;
+    }
+    _reset_if_empty();
+  }
+
+  /**
+   * Remove all elements
+   */
+  void clear() {
+    _size = 0;
+    _reset_if_empty();
+  }
+};
@@ -12,6 +12,35 @@
 #include <stdexcept>
 #include <type_traits>
 #include <iostream>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <compare>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <system_error>
+#define DEQUE_HAS_SCATTER_GATHER_IO 1
+#endif
+
+namespace deque_detail {
+  struct lifecycle_access;
+
+  /**
+   * Check if equality of elements is equality of their bytes, user-defined operator== may differ
+   * @tparam T elements type
+   */
+  template <typename T>
+  inline constexpr bool bytewise_equal_v =
+    (std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T> || std::is_pointer_v<T>;
+}
 
 /**
  * @brief Deque class.
@@ -20,6 +49,8 @@
  */
 template <typename T, typename Allocator = std::allocator<T>>
 class deque {
+  friend struct deque_detail::lifecycle_access;
+
 private:
   /**
    * @brief deque iterator class 
@@ -27,9 +58,16 @@ private:
    * @tparam Allocator allocator type
    */
   template <bool IsConst>
-  class common_iterator : public std::iterator<std::random_access_iterator_tag, T> {
+  class common_iterator {
     friend class deque;
 
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, T const*, T*>;
+    using reference = std::conditional_t<IsConst, T const&, T&>;
+
   private:
     T** data; ///< pointer to array of arrays
     size_t i; ///< index in dynamic array
@@ -41,19 +79,19 @@ private:
      * @pram[in] i index in dynamic array
      * @pram[in] j index in fixed-size array
      */
-    common_iterator(T** data, size_t i, size_t j) : data(data), i(i), j(j) {};
+    constexpr common_iterator(T** data, size_t i, size_t j) : data(data), i(i), j(j) {};
 
   public:
     /**
      * Default constructor
      */
-    common_iterator() = default;
+    constexpr common_iterator() = default;
 
     /**
      * Copy constructor
      * @param[in] other iterator to copy
      */
-    common_iterator(common_iterator const& other) noexcept {
+    constexpr common_iterator(common_iterator const& other) noexcept {
       data = other.data;
       i = other.i;
       j = other.j;
@@ -64,7 +102,7 @@ private:
      * @param[in] other iterator to copy
      * @return reference to this iterator
      */
-    common_iterator& operator=(common_iterator const& other) noexcept {
+    constexpr common_iterator& operator=(common_iterator const& other) noexcept {
       data = other.data;
       i = other.i;
       j = other.j;
@@ -75,7 +113,7 @@ private:
      * Dereference operator *
      * @return reference (const reference for const iterator) to the pointed-to element 
      */
-    std::conditional_t<IsConst, T const&, T&> operator*() const noexcept {
+    constexpr std::conditional_t<IsConst, T const&, T&> operator*() const noexcept {
       return data[i][j];
     }
 
@@ -83,7 +121,7 @@ private:
      * Dereference operator ->
      * @return pointer (const pointer for const iterator) to the pointed-to element
      */
-    std::conditional_t<IsConst, T const*, T*> operator->() const noexcept {
+    constexpr std::conditional_t<IsConst, T const*, T*> operator->() const noexcept {
       return data[i] + j;
     }
 
@@ -91,7 +129,7 @@ private:
      * Prefix increment
      * @return reference to this iterator
      */
-    common_iterator& operator++() noexcept {
+    constexpr common_iterator& operator++() noexcept {
       ++j;
       if (j == FIXED_ARRAY_SIZE) {
         j = 0;
@@ -104,7 +142,7 @@ private:
      * Postfix increment
      * @return previous value of this iterator
      */
-    common_iterator operator++(int) noexcept {
+    constexpr common_iterator operator++(int) noexcept {
       common_iterator tmp = *this;
       ++(*this);
       return tmp;
@@ -114,7 +152,7 @@ private:
      * Prefix decrement
      * @return reference to this iterator
      */
-    common_iterator& operator--() noexcept {
+    constexpr common_iterator& operator--() noexcept {
       --j;
       if (j == -1) {
         j = FIXED_ARRAY_SIZE - 1;
@@ -127,7 +165,7 @@ private:
      * Postfix decrement
      * @return previous value of this iterator
      */
-    common_iterator operator--(int) noexcept {
+    constexpr common_iterator operator--(int) noexcept {
       common_iterator tmp = *this;
       --(*this);
       return tmp;
@@ -138,7 +176,7 @@ private:
      * @param[in] other iterator to compare
      * @return true if iterators point to the same element else false
      */
-    bool operator==(common_iterator const& other) const noexcept {
+    constexpr bool operator==(common_iterator const& other) const noexcept {
       return i == other.i && j == other.j;
     }
 
@@ -147,7 +185,7 @@ private:
      * @param[in] other iterator to compare
      * @return true if iterators point to the different elements else false
      */
-    bool operator!=(common_iterator const& other) const noexcept {
+    constexpr bool operator!=(common_iterator const& other) const noexcept {
       return !(*this == other);
     }
 
@@ -156,7 +194,7 @@ private:
      * @param[in] other iterator to compare
      * @return true if the first iterator point to element to the left of the second iterator point-to else false
      */
-    bool operator<(common_iterator const& other) const noexcept {
+    constexpr bool operator<(common_iterator const& other) const noexcept {
       if (i < other.i)
         return true;
       else if (i > other.i)
@@ -170,7 +208,7 @@ private:
      * @param[in] other iterator to compare
      * @return true if the first iterator point to element to the left of the second iterator point-to or they equal else false
      */
-    bool operator<=(common_iterator const& other) const noexcept {
+    constexpr bool operator<=(common_iterator const& other) const noexcept {
       return *this < other || *this == other;
     }
 
@@ -179,7 +217,7 @@ private:
      * @param[in] other iterator to compare
      * @return true if the first iterator point to element to the right of the second iterator point-to else false
      */
-    bool operator>(common_iterator const& other) const noexcept {
+    constexpr bool operator>(common_iterator const& other) const noexcept {
       return !(*this <= other);
     }
 
@@ -188,7 +226,7 @@ private:
      * @param[in] other iterator to compare
      * @return true if the first iterator point to element to the right of the second iterator point-to or they equal else false
      */
-    bool operator>=(common_iterator const& other) const noexcept {
+    constexpr bool operator>=(common_iterator const& other) const noexcept {
       return !(*this < other);
     }
 
@@ -197,7 +235,7 @@ private:
      * @param[in] n number of positions
      * @return reference to this iterator
      */
-    common_iterator& operator+=(difference_type n) noexcept {
+    constexpr common_iterator& operator+=(difference_type n) noexcept {
       if (n < 0)
         return *this -= n;
       if (n < (difference_type)(FIXED_ARRAY_SIZE - j)) {
@@ -217,7 +255,7 @@ private:
      * @param[in] n number of positions
      * @return result iterator
      */
-    common_iterator operator+(difference_type n) const noexcept {
+    constexpr common_iterator operator+(difference_type n) const noexcept {
       common_iterator tmp = *this;
       tmp += n;
       return tmp;
@@ -229,7 +267,7 @@ private:
      * @param[in] it iterator to shift
      * @return result iterator
      */
-    friend common_iterator operator+(difference_type n, common_iterator const& it) noexcept {
+    friend constexpr common_iterator operator+(difference_type n, common_iterator const& it) noexcept {
       return it + n;
     }
 
@@ -238,7 +276,7 @@ private:
      * @param[in] n number of positions
      * @return reference to this iterator
      */
-    common_iterator& operator-=(difference_type n) noexcept {
+    constexpr common_iterator& operator-=(difference_type n) noexcept {
       if (n < 0)
         return *this += n;
       if (n <= (difference_type)j) {
@@ -262,7 +300,7 @@ private:
      * @param[in] n number of positions
      * @return result iterator
      */
-    common_iterator operator-(difference_type n) const noexcept {
+    constexpr common_iterator operator-(difference_type n) const noexcept {
       common_iterator tmp = *this;
       tmp -= n;
       return tmp;
@@ -273,21 +311,165 @@ private:
      * @param[in] other other iterator 
      * @return number n: other + n == *this
      */
-    difference_type operator-(common_iterator const& other) const noexcept {
+    constexpr difference_type operator-(common_iterator const& other) const noexcept {
       return (i * FIXED_ARRAY_SIZE + j) - (other.i * FIXED_ARRAY_SIZE + other.j);
     }
   };
 
+  /**
+   * @brief deque cursor staying valid while elements are pushed to both ends.
+   *
+   * Cursor addresses element by sequence number (see front_seq()) and caches its indexes together
+   * with generation of deque. Generation changes whenever dynamic array moves, then the next access
+   * recomputes indexes from sequence number in O(1).
+   */
+  class stable_cursor {
+    friend class deque;
+
+  private:
+    deque const* owner = nullptr;  ///< deque of element
+    uint64_t seq = 0;              ///< sequence number of element
+    mutable uint64_t gen = 0;      ///< generation of deque the indexes were computed for
+    mutable size_t i = 0;          ///< cached index in dynamic array
+    mutable size_t j = 0;          ///< cached index in fixed-size array
+
+    /**
+     * Constructor from deque and sequence number
+     * @pram[in] owner deque of element
+     * @pram[in] seq sequence number of element
+     */
+    constexpr stable_cursor(deque const* owner, uint64_t seq) noexcept : owner(owner), seq(seq) {
+      _locate();
+    }
+
+    /**
+     * Compute indexes from sequence number
+     */
+    constexpr void _locate() const noexcept {
+      size_t k = owner->first_j + (size_t)(seq - owner->base_seq);
+      i = owner->first_i + k / FIXED_ARRAY_SIZE;
+      j = k % FIXED_ARRAY_SIZE;
+      gen = owner->generation;
+    }
+
+  public:
+    /**
+     * Default constructor of cursor not bound to deque, only valid() and sequence() may be called
+     */
+    constexpr stable_cursor() = default;
+
+    /**
+     * Check if cursor points to element of deque
+     * @return true if cursor is bound to deque and element with its sequence number is in deque else false
+     */
+    constexpr bool valid() const noexcept {
+      return owner != nullptr && seq - owner->base_seq < owner->_size;
+    }
+
+    /**
+     * Get sequence number of pointed-to element
+     * @return sequence number
+     */
+    constexpr uint64_t sequence() const noexcept {
+      return seq;
+    }
+
+    /**
+     * Get number of position of pointed-to element
+     * @return number of position
+     * @warning cursor must be bound to deque
+     */
+    constexpr size_t position() const noexcept {
+      return (size_t)(seq - owner->base_seq);
+    }
+
+    /**
+     * Dereference operator *
+     * @return reference to the pointed-to element
+     * @warning cursor must be valid
+     */
+    constexpr T& operator*() const noexcept {
+      if (gen != owner->generation)
+        _locate();
+      return owner->data[i][j];
+    }
+
+    /**
+     * Dereference operator ->
+     * @return pointer to the pointed-to element
+     * @warning cursor must be valid
+     */
+    constexpr T* operator->() const noexcept {
+      return &**this;
+    }
+
+    /**
+     * Prefix increment
+     * @return reference to this cursor
+     * @warning cursor must be bound to deque
+     */
+    constexpr stable_cursor& operator++() noexcept {
+      ++seq;
+      if (gen != owner->generation)
+        return *this;
+      ++j;
+      if (j == FIXED_ARRAY_SIZE) {
+        j = 0;
+        ++i;
+      }
+      return *this;
+    }
+
+    /**
+     * Prefix decrement
+     * @return reference to this cursor
+     * @warning cursor must be bound to deque
+     */
+    constexpr stable_cursor& operator--() noexcept {
+      --seq;
+      if (gen != owner->generation)
+        return *this;
+      if (j == 0) {
+        j = FIXED_ARRAY_SIZE;
+        --i;
+      }
+      --j;
+      return *this;
+    }
+
+    /**
+     * Move cursor by n elements
+     * @param[in] n number of elements
+     * @return reference to this cursor
+     * @warning cursor must be bound to deque
+     */
+    constexpr stable_cursor& operator+=(std::ptrdiff_t n) noexcept {
+      seq += (uint64_t)n;
+      _locate();
+      return *this;
+    }
+
+    /**
+     * Check if cursors point to the same element
+     * @param[in] other other cursor
+     * @return true if sequence numbers are equal else false
+     */
+    constexpr bool operator==(stable_cursor const& other) const noexcept {
+      return seq == other.seq;
+    }
+  };
+
   static constexpr size_t FIXED_ARRAY_SIZE = 4;         ///< size of fixed-size arrays
   static constexpr size_t DYNAMIC_ARRAY_START_SIZE = 3; ///< dynamic array start size
+  static constexpr size_t REALTIME_MIGRATE_STEPS = 2;   ///< pointers migrated per push in real-time mode
 
   using alloc_traits = std::allocator_traits<Allocator>;
 
-  template <typename T>
-  using PtrAllocator = typename alloc_traits::template rebind_alloc<T*>; ///< type of allocator for dynamic array
+  template <typename U>
+  using PtrAllocator = typename alloc_traits::template rebind_alloc<U*>; ///< type of allocator for dynamic array
 
-  template <typename T>
-  using ptr_alloc_traits = typename alloc_traits::template rebind_traits<T*>;
+  template <typename U>
+  using ptr_alloc_traits = typename alloc_traits::template rebind_traits<U*>;
 
   T** data = nullptr;           ///< dynamic array of fixed-size arrays
   size_t _size = 0;             ///< number of elements in deque
@@ -298,14 +480,36 @@ private:
   size_t first_j = 0;                             ///< index of the first element in fixed-size array
   size_t last_i = first_i;                        ///< index of last element in dynamic array
   size_t last_j = first_j;                         ///< index of last element in fixed-size array
+  uint64_t base_seq = 0;                           ///< sequence number of the first element
+  uint64_t generation = 0;                         ///< changes when dynamic array moves (see stable_cursor)
+
+  bool realtime = false;       ///< dynamic array grows incrementally (see set_realtime_growth())
+  T** map_buf = nullptr;       ///< buffer containing dynamic array in real-time mode
+  size_t map_cap = 0;          ///< capacity of map_buf
+  T** next_buf = nullptr;      ///< buffer receiving dynamic array during incremental migration
+  size_t next_cap = 0;         ///< capacity of next_buf
+  std::ptrdiff_t next_shift = 0;  ///< next_buf index minus map_buf index of the same slot
+  size_t migrate_lo = 0;       ///< index in map_buf of the first slot copied to next_buf
+  size_t migrate_hi = 0;       ///< index in map_buf after the last slot copied to next_buf
 
   Allocator alloc;            ///< allocator for fixed-size arrays of elemetns
   PtrAllocator<T> ptr_alloc;  ///< allocator for dynamic array of pointers
 
+  /**
+   * Store pointer to fixed-size array in freshly allocated dynamic array
+   * param[in] arr dynamic array
+   * param[in] i index in dynamic array
+   * param[in] block pointer to fixed-size array
+   */
+  constexpr void _set_block(T** arr, size_t i, T* block) noexcept {
+    // construct instead of assignment: constant evaluation needs the pointer object to be alive
+    ptr_alloc_traits<T>::construct(ptr_alloc, arr + i, block);
+  }
+
   /*
    * Clear deque and deallocate memory 
    */
-  void _clear_with_deallocate() noexcept {
+  constexpr void _clear_with_deallocate() noexcept {
     for (size_t i = 0; i < dynamic_arr_size; ++i) {
       size_t j = 0;
       size_t end = FIXED_ARRAY_SIZE;
@@ -319,19 +523,32 @@ private:
       }
       alloc_traits::deallocate(alloc, data[i], FIXED_ARRAY_SIZE);
     }
-    ptr_alloc_traits<T>::deallocate(ptr_alloc, data, dynamic_arr_size);
+    if (realtime) {
+      if (next_buf != nullptr)
+        ptr_alloc_traits<T>::deallocate(ptr_alloc, next_buf, next_cap);
+      ptr_alloc_traits<T>::deallocate(ptr_alloc, map_buf, map_cap);
+    }
+    else if (data != nullptr) {
+      ptr_alloc_traits<T>::deallocate(ptr_alloc, data, dynamic_arr_size);
+    }
 
     _size = 0;
     _max_size = 0;
     dynamic_arr_size = 0;
     data = nullptr;
+    realtime = false;
+    map_buf = nullptr;
+    map_cap = 0;
+    next_buf = nullptr;
+    next_cap = 0;
+    ++generation;
   }
 
   /**
    * Copy other deque
    * param[in] otehr deque to copy
    */
-  void _copy(deque const& other) {
+  constexpr void _copy(deque const& other) {
     alloc = alloc_traits::select_on_container_copy_construction(other.alloc);
     ptr_alloc = ptr_alloc_traits<T>::select_on_container_copy_construction(other.ptr_alloc);
 
@@ -342,17 +559,14 @@ private:
     first_j = other.first_j;
     last_i = other.last_i;
     last_j = other.last_j;
+    base_seq = other.base_seq;
+    ++generation;
 
-    try {
-      data = ptr_alloc_traits<T>::allocate(ptr_alloc, dynamic_arr_size);
-    }
-    catch (...) {
-      throw;
-    }
+    data = ptr_alloc_traits<T>::allocate(ptr_alloc, dynamic_arr_size);
 
     for (size_t i = 0; i < dynamic_arr_size; ++i) {
       try {
-        data[i] = alloc_traits::allocate(this->alloc, FIXED_ARRAY_SIZE);
+        _set_block(data, i, alloc_traits::allocate(this->alloc, FIXED_ARRAY_SIZE));
       }
       catch (...) {
         for (size_t j = 0; j < i; ++j) {
@@ -380,21 +594,19 @@ private:
       for (size_t j = 0; j < last_j; ++j)
         alloc_traits::construct(alloc, data[last_i] + j, other.data[last_i][j]);
     }
+
+    if (other.realtime)
+      set_realtime_growth(true);
   }
 
   /**
    * Move other deque
    * param[in] otehr deque to move
    */
-  void _move(deque& other) {
+  constexpr void _move(deque& other) {
     if (alloc_traits::propagate_on_container_move_assignment::value && alloc != other.alloc) {
-      try {
-        alloc = std::move(other.alloc);
-        ptr_alloc = std::move(other.ptr_alloc);
-      }
-      catch (...) {
-        throw;
-      }
+      alloc = std::move(other.alloc);
+      ptr_alloc = std::move(other.ptr_alloc);
     }
 
     data = other.data;
@@ -405,6 +617,16 @@ private:
     first_j = other.first_j;
     last_i = other.last_i;
     last_j = other.last_j;
+    base_seq = other.base_seq;
+    ++generation;
+    realtime = other.realtime;
+    map_buf = other.map_buf;
+    map_cap = other.map_cap;
+    next_buf = other.next_buf;
+    next_cap = other.next_cap;
+    next_shift = other.next_shift;
+    migrate_lo = other.migrate_lo;
+    migrate_hi = other.migrate_hi;
 
     other.data = nullptr;
     other._size = 0;
@@ -414,34 +636,33 @@ private:
     other.first_j = 0;
     other.last_i = 0;
     other.last_j = 0;
+    other.base_seq = 0;
+    ++other.generation;
+    other.realtime = false;
+    other.map_buf = nullptr;
+    other.map_cap = 0;
+    other.next_buf = nullptr;
+    other.next_cap = 0;
   }
 
   /**
    * Increase dynamic array max size
    * param[in] shift false to increase on the right or true to increase to the left
    */
-  void _increase_size(bool shift) {
-    T** new_dynamic_arr;
-
-    try {
-      new_dynamic_arr = ptr_alloc_traits<T>::allocate(ptr_alloc, dynamic_arr_size + 1);
-    }
-    catch (std::bad_alloc) {
-      throw;
+  constexpr void _increase_size(bool shift) {
+    if (realtime) {
+      _grow_realtime(shift);
+      return;
     }
 
-    T* new_fixed_arr;
-    try {
-      new_fixed_arr = alloc_traits::allocate(alloc, FIXED_ARRAY_SIZE);
-    }
-    catch (std::bad_alloc) {
-      throw;
-    }
+    T** new_dynamic_arr = ptr_alloc_traits<T>::allocate(ptr_alloc, dynamic_arr_size + 1);
+
+    T* new_fixed_arr = alloc_traits::allocate(alloc, FIXED_ARRAY_SIZE);
 
     for (size_t i = 0; i < dynamic_arr_size; ++i)
-      new_dynamic_arr[i + shift] = data[i];
+      _set_block(new_dynamic_arr, i + shift, data[i]);
 
-    new_dynamic_arr[shift ? 0 : dynamic_arr_size] = new_fixed_arr;
+    _set_block(new_dynamic_arr, shift ? 0 : dynamic_arr_size, new_fixed_arr);
 
     first_i += shift;
     last_i += shift;
@@ -450,6 +671,138 @@ private:
     data = new_dynamic_arr;
     ++dynamic_arr_size;
     _max_size += FIXED_ARRAY_SIZE;
+    ++generation;
+  }
+
+  /**
+   * Get capacity of dynamic array buffer for real-time mode: twice the current size free on both sides
+   * @return number of slots
+   */
+  constexpr size_t _realtime_capacity() const noexcept {
+    return 4 * dynamic_arr_size + 2 * DYNAMIC_ARRAY_START_SIZE;
+  }
+
+  /**
+   * Allocate buffer for incremental migration of dynamic array, placing it in the middle
+   */
+  constexpr void _start_migration() {
+    size_t lo = data - map_buf;
+    size_t cap = _realtime_capacity();
+    next_buf = ptr_alloc_traits<T>::allocate(ptr_alloc, cap);
+    next_cap = cap;
+    next_shift = (std::ptrdiff_t)((cap - dynamic_arr_size) / 2) - (std::ptrdiff_t)lo;
+    migrate_lo = lo + dynamic_arr_size / 2;
+    migrate_hi = migrate_lo;
+  }
+
+  /**
+   * Copy pointers to fixed-size arrays to migration buffer and switch to it when all of them are copied
+   * param[in] steps max number of pointers to copy
+   */
+  constexpr void _migrate(size_t steps) noexcept {
+    size_t lo = data - map_buf;
+    size_t hi = lo + dynamic_arr_size;
+    for (; steps > 0 && (migrate_lo > lo || migrate_hi < hi); --steps) {
+      if (migrate_hi < hi) {
+        _set_block(next_buf, migrate_hi + next_shift, map_buf[migrate_hi]);
+        ++migrate_hi;
+      }
+      else {
+        --migrate_lo;
+        _set_block(next_buf, migrate_lo + next_shift, map_buf[migrate_lo]);
+      }
+    }
+    if (migrate_lo > lo || migrate_hi < hi)
+      return;
+
+    ptr_alloc_traits<T>::deallocate(ptr_alloc, map_buf, map_cap);
+    map_buf = next_buf;
+    map_cap = next_cap;
+    data = next_buf + (lo + next_shift);
+    next_buf = nullptr;
+    next_cap = 0;
+    ++generation;
+  }
+
+  /**
+   * Do bounded part of dynamic array migration before push in real-time mode
+   */
+  constexpr void _realtime_step() {
+    if (!realtime)
+      return;
+    if (next_buf != nullptr) {
+      _migrate(REALTIME_MIGRATE_STEPS);
+      return;
+    }
+
+    size_t lo = data - map_buf;
+    size_t hi = lo + dynamic_arr_size;
+    if (lo < dynamic_arr_size || map_cap - hi < dynamic_arr_size)
+      _start_migration();
+  }
+
+  /**
+   * Add fixed-size array to dynamic array in real-time mode, using free space of buffer
+   * param[in] shift false to increase on the right or true to increase to the left
+   */
+  constexpr void _grow_realtime(bool shift) {
+    size_t lo = data - map_buf;
+    if (shift ? lo == 0 : lo + dynamic_arr_size == map_cap) {
+      // migration did not keep up, finish it at once
+      if (next_buf == nullptr)
+        _start_migration();
+      _migrate(SIZE_MAX);
+    }
+
+    T* new_fixed_arr = alloc_traits::allocate(alloc, FIXED_ARRAY_SIZE);
+    if (shift) {
+      --data;
+      ++first_i;
+      ++last_i;
+      ++generation;
+      _set_block(data, 0, new_fixed_arr);
+    }
+    else {
+      _set_block(data, dynamic_arr_size, new_fixed_arr);
+    }
+    ++dynamic_arr_size;
+    _max_size += FIXED_ARRAY_SIZE;
+  }
+
+  /**
+   * Deallocate the first fixed-size array in real-time mode
+   * @warning the first fixed-size array must not contain elements
+   */
+  constexpr void _release_front_array() noexcept {
+    alloc_traits::deallocate(alloc, data[0], FIXED_ARRAY_SIZE);
+    ++data;
+    --dynamic_arr_size;
+    --first_i;
+    --last_i;
+    ++generation;
+    _max_size -= FIXED_ARRAY_SIZE;
+
+    size_t lo = data - map_buf;
+    if (migrate_lo < lo)
+      migrate_lo = lo;
+    if (migrate_hi < migrate_lo)
+      migrate_hi = migrate_lo;
+  }
+
+  /**
+   * Deallocate the last fixed-size array in real-time mode
+   * @warning the last fixed-size array must not contain elements
+   */
+  constexpr void _release_back_array() noexcept {
+    --dynamic_arr_size;
+    alloc_traits::deallocate(alloc, data[dynamic_arr_size], FIXED_ARRAY_SIZE);
+    _max_size -= FIXED_ARRAY_SIZE;
+
+    size_t hi = (data - map_buf) + dynamic_arr_size;
+    if (migrate_hi > hi)
+      migrate_hi = hi;
+    if (migrate_lo > migrate_hi)
+      migrate_lo = migrate_hi;
   }
 
   /**
@@ -457,23 +810,17 @@ private:
    * param[in] side false to cut on the right or true to cut to the left
    * param[in] new_array_size new dynamic array size
    */
-  void _reduce_size(bool side, size_t new_array_size) {
+  constexpr void _reduce_size(bool side, size_t new_array_size) {
     if (dynamic_arr_size <= new_array_size || !new_array_size)
       return;
 
-    T** new_arr;
-    try {
-      new_arr = ptr_alloc_traits<T>::allocate(ptr_alloc, new_array_size);
-    }
-    catch (std::bad_alloc) {
-      throw;
-    }
+    T** new_arr = ptr_alloc_traits<T>::allocate(ptr_alloc, new_array_size);
 
     size_t lborder = side ? dynamic_arr_size - new_array_size : 0;
     size_t rborder = side ? dynamic_arr_size : new_array_size;
     size_t j = 0;
     for (size_t i = lborder; i < rborder; ++i, ++j)
-      new_arr[j] = data[i];
+      _set_block(new_arr, j, data[i]);
 
     lborder = side ? 0 : new_array_size;
     rborder = side ? dynamic_arr_size - new_array_size : dynamic_arr_size;
@@ -486,17 +833,288 @@ private:
     data = new_arr;
     dynamic_arr_size = new_array_size;
     _max_size = dynamic_arr_size * FIXED_ARRAY_SIZE;
+    ++generation;
+  }
+
+  /**
+   * Destroy elements of fixed-size array
+   * param[in] first pointer to the first element to destroy
+   * param[in] count number of elements to destroy
+   */
+  constexpr void _destroy(T* first, size_t count) noexcept {
+    if (std::is_trivially_destructible<T>::value)
+      return;
+    for (size_t j = 0; j < count; ++j)
+      alloc_traits::destroy(alloc, first + j);
+  }
+
+  /**
+   * Reduce dynamic array once after removing several elements from the front,
+   * to the size that repeated pop_front() calls would leave
+   */
+  constexpr void _shrink_front() {
+    if (realtime) {
+      // keep one spare fixed-size array, every release is O(1)
+      while (first_i > 1)
+        _release_front_array();
+      return;
+    }
+
+    size_t new_array_size = dynamic_arr_size;
+    size_t i = first_i;
+    while (i > new_array_size / 2 && new_array_size / 2 + 1 < new_array_size) {
+      i -= new_array_size - (new_array_size / 2 + 1);
+      new_array_size = new_array_size / 2 + 1;
+    }
+    _reduce_size(true, new_array_size);
+  }
+
+  /**
+   * Reduce dynamic array once after removing several elements from the back,
+   * to the size that repeated pop_back() calls would leave
+   */
+  constexpr void _shrink_back() {
+    if (realtime) {
+      while (dynamic_arr_size > last_i + 2)
+        _release_back_array();
+      return;
+    }
+
+    size_t new_array_size = dynamic_arr_size;
+    while (last_i < new_array_size / 2 && new_array_size / 2 + 1 < new_array_size)
+      new_array_size = new_array_size / 2 + 1;
+    _reduce_size(false, new_array_size);
+  }
+
+  /**
+   * Remove n elements from the front fixed-size array by fixed-size array
+   * param[in] n number of elements to remove, not greater than size
+   * param[in] fn callback taking pointer to the first element and number of elements, called before destroying them
+   */
+  template <typename Fn>
+  constexpr void _pop_front_blocks(size_t n, Fn&& fn) {
+    size_t left = n;
+    while (left > 0) {
+      size_t count = FIXED_ARRAY_SIZE - first_j < left ? FIXED_ARRAY_SIZE - first_j : left;
+      fn(data[first_i] + first_j, count);
+      _destroy(data[first_i] + first_j, count);
+      first_j += count;
+      left -= count;
+      _size -= count;
+      base_seq += count;
+      if (first_j == FIXED_ARRAY_SIZE) {
+        ++first_i;
+        first_j = 0;
+      }
+    }
+
+    _shrink_front();
+  }
+
+  /**
+   * Move run of elements to write position fixed-size array by fixed-size array
+   * param[in] src pointer to the first element of run in one fixed-size array
+   * param[in] count number of elements in run
+   * param[in,out] wi index of write position in dynamic array
+   * param[in,out] wj index of write position in fixed-size array
+   * @warning write position must not be after src
+   */
+  constexpr void _compact_run(T* src, size_t count, size_t& wi, size_t& wj) {
+    while (count > 0) {
+      size_t chunk = FIXED_ARRAY_SIZE - wj < count ? FIXED_ARRAY_SIZE - wj : count;
+      T* dst = data[wi] + wj;
+      if (dst != src) {
+        if (std::is_trivially_copyable<T>::value && !std::is_constant_evaluated())
+          std::memmove(static_cast<void*>(dst), static_cast<void const*>(src), chunk * sizeof(T));
+        else
+          std::move(src, src + chunk, dst);
+      }
+      src += chunk;
+      count -= chunk;
+      wj += chunk;
+      if (wj == FIXED_ARRAY_SIZE) {
+        ++wi;
+        wj = 0;
+      }
+    }
+  }
+
+  /**
+   * Walk equal-length prefixes of two deques by runs lying in one fixed-size array of each
+   * param[in] a the first deque
+   * param[in] b the second deque
+   * param[in] n length of prefix, not greater than sizes of deques
+   * param[in] fn function taking pointers to runs and run length, returning false to stop
+   * @return false if fn stopped the walk else true
+   */
+  template <typename Fn>
+  static constexpr bool _zip_segments(deque const& a, deque const& b, size_t n, Fn&& fn) {
+    size_t ka = 0;
+    size_t kb = 0;
+    size_t ja = 0;
+    size_t jb = 0;
+    while (n > 0) {
+      std::pair<T*, size_t> sa = a.segment(ka);
+      std::pair<T*, size_t> sb = b.segment(kb);
+      size_t run = sa.second - ja < sb.second - jb ? sa.second - ja : sb.second - jb;
+      run = run < n ? run : n;
+      if (!fn(sa.first + ja, sb.first + jb, run))
+        return false;
+
+      ja += run;
+      jb += run;
+      n -= run;
+      if (ja == sa.second) {
+        ++ka;
+        ja = 0;
+      }
+      if (jb == sb.second) {
+        ++kb;
+        jb = 0;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Header of deque binary image (see save() and load())
+   */
+  struct binary_header {
+    uint32_t magic;         ///< BINARY_MAGIC
+    uint32_t version;       ///< BINARY_VERSION
+    uint64_t element_size;  ///< sizeof(T) of the saved deque
+    uint64_t count;         ///< number of saved elements
+  };
+
+  static constexpr uint32_t BINARY_MAGIC = 0x51454455;  ///< "UDEQ" in little-endian
+  static constexpr uint32_t BINARY_VERSION = 1;         ///< binary image format version
+
+  /**
+   * Replace storage with new empty dynamic array with allocated fixed-size arrays
+   * @param[in] new_dynamic_arr_size number of fixed-size arrays
+   * @warning deque must be deallocated before call
+   */
+  constexpr void _allocate(size_t new_dynamic_arr_size) {
+    data = ptr_alloc_traits<T>::allocate(ptr_alloc, new_dynamic_arr_size);
+
+    for (size_t i = 0; i < new_dynamic_arr_size; ++i) {
+      try {
+        _set_block(data, i, alloc_traits::allocate(alloc, FIXED_ARRAY_SIZE));
+      }
+      catch (...) {
+        for (size_t j = 0; j < i; ++j)
+          alloc_traits::deallocate(alloc, data[j], FIXED_ARRAY_SIZE);
+        ptr_alloc_traits<T>::deallocate(ptr_alloc, data, new_dynamic_arr_size);
+        data = nullptr;
+        throw;
+      }
+    }
+
+    dynamic_arr_size = new_dynamic_arr_size;
+    _max_size = dynamic_arr_size * FIXED_ARRAY_SIZE;
+  }
+
+  /**
+   * Check binary header read from image
+   * @param[in] header header to check
+   */
+  static void _check_header(binary_header const& header) {
+    if (header.magic != BINARY_MAGIC)
+      throw std::runtime_error("not a deque binary image");
+    if (header.version != BINARY_VERSION)
+      throw std::runtime_error("unsupported deque binary image version");
+    if (header.element_size != sizeof(T))
+      throw std::runtime_error("deque binary image element size mismatch");
+  }
+
+#ifdef DEQUE_HAS_SCATTER_GATHER_IO
+  /**
+   * Write or read all the buffers described by iovec array, restarting after partial transfers
+   * @param[in] fd file descriptor
+   * @param[in] iov array of buffers (modified)
+   * @param[in] count number of buffers
+   * @param[in] is_write true to use writev, false to use readv
+   */
+  static void _transfer_all(int fd, struct iovec* iov, size_t count, bool is_write) {
+    while (count > 0) {
+      int batch = (int)(count < (size_t)IOV_MAX ? count : (size_t)IOV_MAX);
+      ssize_t n = is_write ? ::writev(fd, iov, batch) : ::readv(fd, iov, batch);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::system_error(errno, std::generic_category(), is_write ? "writev" : "readv");
+      }
+      if (n == 0 && !is_write)
+        throw std::runtime_error("unexpected end of deque binary image");
+
+      size_t left = (size_t)n;
+      while (count > 0 && left >= iov->iov_len) {
+        left -= iov->iov_len;
+        ++iov;
+        --count;
+      }
+      if (left > 0) {
+        iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+        iov->iov_len -= left;
+      }
+    }
+  }
+#endif
+
+  /**
+   * Describe occupied part of each fixed-size array as buffer
+   * @param[in] fn callback taking pointer to the first element and number of elements
+   */
+  template <typename Fn>
+  constexpr void _for_each_block(Fn&& fn) const {
+    if (first_i == last_i) {
+      if (last_j > first_j)
+        fn(data[first_i] + first_j, last_j - first_j);
+      return;
+    }
+
+    fn(data[first_i] + first_j, FIXED_ARRAY_SIZE - first_j);
+    for (size_t i = first_i + 1; i < last_i; ++i)
+      fn(data[i], FIXED_ARRAY_SIZE);
+    if (last_j > 0)
+      fn(data[last_i], last_j);
+  }
+
+  /**
+   * Tag of constructor without storage
+   */
+  struct no_storage {};
+
+  /**
+   * Constructor of deque without storage, caller allocates it (see deque_detail::lifecycle_access)
+   * param[in] alloc allocator to use in deque
+   */
+  constexpr deque(no_storage, Allocator const& alloc) : alloc(alloc), ptr_alloc(alloc) {}
+
+  /**
+   * Prepare this deque to receive count elements in freshly allocated fixed-size arrays
+   * @param[in] count number of elements
+   */
+  void _prepare_load(size_t count) {
+    _clear_with_deallocate();
+    _allocate(count / FIXED_ARRAY_SIZE + 1);
+    first_i = 0;
+    first_j = 0;
+    last_i = count / FIXED_ARRAY_SIZE;
+    last_j = count % FIXED_ARRAY_SIZE;
+    _size = count;
   }
 
 public:
   using iterator = common_iterator<false>;
   using const_iterator = common_iterator<true>;
+  using cursor = stable_cursor;
 
   /*
    * Begin of deque 
    * @return iterator pointed to the first element of deque 
    */
-  iterator begin() const noexcept{
+  constexpr iterator begin() const noexcept{
     return iterator(data, first_i, first_j);
   }
 
@@ -505,7 +1123,7 @@ public:
    * @return iterator pointed to the next after last element of deque
    * @warning dereferencing can cause undefined behaviour
    */
-  iterator end() const noexcept{
+  constexpr iterator end() const noexcept{
     return iterator(data, last_i, last_j);
   }
 
@@ -513,7 +1131,7 @@ public:
    * Begin of deque
    * @return const iterator pointed to the first element of deque
    */
-  const_iterator cbegin() const noexcept {
+  constexpr const_iterator cbegin() const noexcept {
     return const_iterator(data, first_i, first_j);
   }
 
@@ -522,26 +1140,39 @@ public:
    * @return const iterator pointed to the next after last element of deque
    * @warning dereferencing can cause undefined behaviour
    */
-  const_iterator cend() const noexcept {
+  constexpr const_iterator cend() const noexcept {
     return const_iterator(data, last_i, last_j);
   }
 
+  /**
+   * Make cursor staying valid across pushes to both ends
+   * param[in] pos number of position, may be size() to wait for the next pushed element
+   * @return cursor pointed to element at this position
+   */
+  constexpr cursor make_cursor(size_t pos = 0) const noexcept {
+    return cursor(this, base_seq + pos);
+  }
+
+  /**
+   * Make cursor by sequence number
+   * param[in] seq sequence number of element
+   * @return cursor pointed to element with this sequence number
+   */
+  constexpr cursor cursor_at_seq(uint64_t seq) const noexcept {
+    return cursor(this, seq);
+  }
+
   /**
    * Constructor of empty deque
    * param[in] alloc allocator to use in deque
    */
-  deque(Allocator const& alloc = Allocator()) : alloc(alloc), ptr_alloc(alloc) {
+  constexpr deque(Allocator const& alloc = Allocator()) : alloc(alloc), ptr_alloc(alloc) {
     this->alloc = alloc;
-    try {
-      data = ptr_alloc_traits<T>::allocate(ptr_alloc, DYNAMIC_ARRAY_START_SIZE);
-    }
-    catch (...) {
-      throw;
-    }
+    data = ptr_alloc_traits<T>::allocate(ptr_alloc, DYNAMIC_ARRAY_START_SIZE);
     dynamic_arr_size = DYNAMIC_ARRAY_START_SIZE;
     for (size_t i = 0; i < dynamic_arr_size; ++i) {
       try {
-        data[i] = alloc_traits::allocate(this->alloc, FIXED_ARRAY_SIZE);
+        _set_block(data, i, alloc_traits::allocate(this->alloc, FIXED_ARRAY_SIZE));
       }
       catch (...) {
         for (size_t j = 0; j < i; ++j) {
@@ -561,19 +1192,19 @@ public:
    * param[in] value value of elemnts
    * param[in] alloc allocator to use in deque
    */
-  deque(size_t count, T const& value = T(), Allocator const& alloc = Allocator()) : alloc(alloc), ptr_alloc(alloc) {
+  constexpr deque(size_t count, T const& value = T(), Allocator const& alloc = Allocator()) : alloc(alloc), ptr_alloc(alloc) {
     dynamic_arr_size = count / FIXED_ARRAY_SIZE + 1;
     try {
       data = ptr_alloc_traits<T>::allocate(ptr_alloc, dynamic_arr_size);
     }
-    catch (std::bad_alloc){
+    catch (...) {
       dynamic_arr_size = 0;
       throw;
     }
 
     for (size_t i = 0; i < dynamic_arr_size; ++i) {
       try {
-        data[i] = alloc_traits::allocate(this->alloc, FIXED_ARRAY_SIZE);
+        _set_block(data, i, alloc_traits::allocate(this->alloc, FIXED_ARRAY_SIZE));
       }
       catch (...) {
         for (size_t j = 0; j < i; ++j) {
@@ -599,26 +1230,16 @@ public:
    * Copy constructor
    * param[in] other deque to copy
    */
-  deque(deque const& other) {
-    try {
-      _copy(other);
-    }
-    catch (std::bad_alloc) {
-      throw;
-    }
+  constexpr deque(deque const& other) {
+    _copy(other);
   }
 
   /**
    * Move constructor
    * param[in] other deque to move
    */
-  deque(deque&& other) {
-    try {
-      _move(other);
-    }
-    catch (...) {
-      throw;
-    }
+  constexpr deque(deque&& other) {
+    _move(other);
   }
   
   /**
@@ -626,18 +1247,13 @@ public:
    * param[in] other deque to copy
    * @return reference to this deque
    */
-  deque& operator=(deque const& other) {
+  constexpr deque& operator=(deque const& other) {
     if (this == &other)
       return *this;
 
     _clear_with_deallocate();
 
-    try {
-      _copy(other);
-    }
-    catch (...) {
-      throw;
-    }
+    _copy(other);
 
     return *this;
   }
@@ -647,7 +1263,7 @@ public:
    * param[in] other deque to move
    * @return reference to this deque
    */
-  deque& operator=(deque&& other) noexcept {
+  constexpr deque& operator=(deque&& other) noexcept {
     if (this == &other)
       return *this;
 
@@ -662,7 +1278,7 @@ public:
    * param[in] pos number of position
    * @return reference to element at this position
    */
-  T& at(size_t pos) const {
+  constexpr T& at(size_t pos) const {
     if (pos >= _size)
       throw std::out_of_range("index out of range");
 
@@ -675,7 +1291,7 @@ public:
    * @return reference to element at this position
    * @warning does not throw out of range exception
    */
-  T& operator[](size_t pos) const noexcept {
+  constexpr T& operator[](size_t pos) const noexcept {
     if (pos < FIXED_ARRAY_SIZE - first_j)
       return data[first_i][first_j + pos];
 
@@ -691,7 +1307,7 @@ public:
    * Get the first element of deque
    * @return reference to the first element of deque
    */
-  T& front() const noexcept {
+  constexpr T& front() const noexcept {
     return data[first_i][first_j];
   }
 
@@ -699,7 +1315,7 @@ public:
    * Get lst element of deque
    * @return reference to the last element of deque
    */
-  T& back() const noexcept {
+  constexpr T& back() const noexcept {
     return (*this)[_size - 1];
   }
   
@@ -707,7 +1323,7 @@ public:
    * Check if deque is empty
    * @return true if deque is empty else false
    */
-  bool empty() const noexcept {
+  constexpr bool empty() const noexcept {
     return _size == 0;
   }
   
@@ -715,7 +1331,7 @@ public:
    * Get number of elemetn in deque
    * @return number of elemetn in deque
    */
-  size_t size() const noexcept {
+  constexpr size_t size() const noexcept {
     return _size;
   }
 
@@ -723,18 +1339,133 @@ public:
    * Get capacity of deque
    * @return capacity of deque
    */
-  size_t max_size() const noexcept {
+  constexpr size_t max_size() const noexcept {
     return _max_size;
   }
   
+  /**
+   * Get number of segments (occupied parts of fixed-size arrays)
+   * @return number of segments
+   */
+  constexpr size_t segment_count() const noexcept {
+    if (_size == 0)
+      return 0;
+    return last_i - first_i + (last_j > 0 ? 1 : 0);
+  }
+
+  /**
+   * Get segment (contiguous occupied part of fixed-size array)
+   * @param[in] k segment number, less than segment_count()
+   * @return pointer to the first element of segment and number of elements in it
+   */
+  constexpr std::pair<T*, size_t> segment(size_t k) const noexcept {
+    size_t i = first_i + k;
+    size_t begin = k == 0 ? first_j : 0;
+    size_t end = i == last_i ? last_j : FIXED_ARRAY_SIZE;
+    return std::pair<T*, size_t>(data[i] + begin, end - begin);
+  }
+
+  /**
+   * Get position of segment in deque
+   * @param[in] k segment number, less than segment_count()
+   * @return number of position of the first element of segment
+   */
+  constexpr size_t segment_start(size_t k) const noexcept {
+    return k == 0 ? 0 : FIXED_ARRAY_SIZE - first_j + (k - 1) * FIXED_ARRAY_SIZE;
+  }
+
+  /**
+   * Switch real-time growth mode.
+   * In real-time mode dynamic array lives in a buffer with free space on both sides. When the space
+   * runs low, a bigger buffer is allocated and every push copies a few pointers to it, so push_back()
+   * and push_front() never copy the whole dynamic array. Empty fixed-size arrays are released one by
+   * one instead of shrinking dynamic array.
+   * param[in] enable true to turn real-time mode on, false to turn it off
+   * @warning switching itself copies the whole dynamic array
+   */
+  constexpr void set_realtime_growth(bool enable) {
+    if (enable == realtime)
+      return;
+    if (data == nullptr)
+      *this = deque();
+    if (next_buf != nullptr)
+      _migrate(SIZE_MAX);
+
+    size_t cap = enable ? _realtime_capacity() : dynamic_arr_size;
+    size_t lo = enable ? (cap - dynamic_arr_size) / 2 : 0;
+    T** buf = ptr_alloc_traits<T>::allocate(ptr_alloc, cap);
+    for (size_t i = 0; i < dynamic_arr_size; ++i)
+      _set_block(buf, lo + i, data[i]);
+
+    if (realtime)
+      ptr_alloc_traits<T>::deallocate(ptr_alloc, map_buf, map_cap);
+    else
+      ptr_alloc_traits<T>::deallocate(ptr_alloc, data, dynamic_arr_size);
+    data = buf + lo;
+    map_buf = enable ? buf : nullptr;
+    map_cap = enable ? cap : 0;
+    realtime = enable;
+    ++generation;
+  }
+
+  /**
+   * Check if real-time growth mode is on
+   * @return true if dynamic array grows incrementally else false
+   */
+  constexpr bool realtime_growth() const noexcept {
+    return realtime;
+  }
+
+  /**
+   * Get sequence number of the first element.
+   * Every element gets a sequence number when it is pushed: one more than the last element has
+   * or one less than the first element has. Numbers do not change when elements are removed
+   * from the ends, so consumers can keep them as offsets
+   * @return sequence number of the first element, of the next pushed element if deque is empty
+   */
+  constexpr uint64_t front_seq() const noexcept {
+    return base_seq;
+  }
+
+  /**
+   * Get sequence number of the last element
+   * @return sequence number of the last element
+   * @warning deque must not be empty
+   */
+  constexpr uint64_t back_seq() const noexcept {
+    return base_seq + _size - 1;
+  }
+
+  /**
+   * Set sequence number of the first element, numbers of other elements follow it
+   * param[in] seq new sequence number
+   */
+  constexpr void set_front_seq(uint64_t seq) noexcept {
+    base_seq = seq;
+    ++generation;
+  }
+
+  /**
+   * Get element by sequence number
+   * param[in] seq sequence number
+   * @return reference to element with this number
+   */
+  constexpr T& at_seq(uint64_t seq) const {
+    if (seq - base_seq >= _size)
+      throw std::out_of_range("sequence number out of range");
+
+    return (*this)[(size_t)(seq - base_seq)];
+  }
+
   /**
    * Add element to the end of deque
    * pram[in] value element to add
    */
-  template <typename T> // universal reference
-  void push_back(T&& value) {
+  template <typename U> // universal reference
+  constexpr void push_back(U&& value) {
     if (data == nullptr)
       *this = deque();
+    _realtime_step();
 
     size_t tmp_last_i = last_i;
     size_t tmp_last_j = last_j;
@@ -750,14 +1481,14 @@ public:
       try {
         _increase_size(false);
       }
-      catch (std::bad_alloc) {
+      catch (...) {
         last_i = tmp_last_i;
         last_j = tmp_last_j;
         throw;
       }
     }
 
-    alloc_traits::construct(alloc, data[i] + j, std::forward<T>(value));
+    alloc_traits::construct(alloc, data[i] + j, std::forward<U>(value));
     ++_size;
   }
   
@@ -766,9 +1497,10 @@ public:
    * pram[in] args constructor parameters
    */
   template <typename... Args>
-  void emplace_back(Args&&... args)  {
+  constexpr void emplace_back(Args&&... args)  {
     if (data == nullptr)
       *this = deque();
+    _realtime_step();
 
     size_t tmp_last_i = last_i;
     size_t tmp_last_j = last_j;
@@ -784,7 +1516,7 @@ public:
       try {
         _increase_size(false);
       }
-      catch (std::bad_alloc) {
+      catch (...) {
         last_i = tmp_last_i;
         last_j = tmp_last_j;
         throw;
@@ -799,10 +1531,11 @@ public:
    * Add element to the front of deque
    * pram[in] value element to add
    */
-  template <typename T> // universal reference
-  void push_front(T&& value) {
+  template <typename U> // universal reference
+  constexpr void push_front(U&& value) {
     if (data == nullptr)
       *this = deque();
+    _realtime_step();
 
     --first_j;
 
@@ -811,7 +1544,7 @@ public:
         try {
           _increase_size(true);
         }
-        catch (std::bad_alloc) {
+        catch (...) {
           first_j = 0;
           throw;
         }
@@ -820,8 +1553,9 @@ public:
       first_j = FIXED_ARRAY_SIZE - 1;
     }
 
-    alloc_traits::construct(alloc, data[first_i] + first_j, std::forward<T>(value));
+    alloc_traits::construct(alloc, data[first_i] + first_j, std::forward<U>(value));
     ++_size;
+    --base_seq;
   }
 
   /**
@@ -829,9 +1563,10 @@ public:
    * pram[in] args constructor parameters
    */
   template<typename... Args>
-  void emplace_front(Args&&... args) {
+  constexpr void emplace_front(Args&&... args) {
     if (data == nullptr)
       *this = deque();
+    _realtime_step();
 
     --first_j;
 
@@ -840,7 +1575,7 @@ public:
         try {
           _increase_size(true);
         }
-        catch (std::bad_alloc) {
+        catch (...) {
           first_j = 0;
           throw;
         }
@@ -851,12 +1586,13 @@ public:
 
     alloc_traits::construct(alloc, data[first_i] + first_j, std::forward<Args>(args)...);
     ++_size;
+    --base_seq;
   }
   
   /**
    * Remove element from the back of deque
    */
-  void pop_back() {
+  constexpr void pop_back() {
     --last_j;
     if (last_j == SIZE_MAX) {
       --last_i;
@@ -865,7 +1601,9 @@ public:
 
     alloc_traits::destroy(alloc, data[last_i] + last_j);
 
-    if (last_i < dynamic_arr_size / 2)
+    if (realtime)
+      _shrink_back();
+    else if (last_i < dynamic_arr_size / 2)
       _reduce_size(false, dynamic_arr_size / 2 + 1);
 
     --_size;
@@ -874,7 +1612,7 @@ public:
   /**
    * Remove element from the front of deque
    */
-  void pop_front() {
+  constexpr void pop_front() {
     alloc_traits::destroy(alloc, data[first_i] + first_j);
 
     ++first_j;
@@ -883,16 +1621,141 @@ public:
       first_j = 0;
     }
 
-    if (first_i > dynamic_arr_size / 2)
+    if (realtime)
+      _shrink_front();
+    else if (first_i > dynamic_arr_size / 2)
       _reduce_size(true, dynamic_arr_size / 2 + 1);
 
     --_size;
+    ++base_seq;
+  }
+
+  /**
+   * Remove n elements from the front of deque
+   * param[in] n number of elements to remove
+   */
+  constexpr void pop_front_n(size_t n) {
+    if (n > _size)
+      throw std::out_of_range("not enough elements");
+
+    _pop_front_blocks(n, [](T*, size_t) {});
+  }
+
+  /**
+   * Remove elements from the front of deque while their sequence numbers are less than seq
+   * param[in] seq sequence number of the first element to keep
+   * @return number of removed elements
+   */
+  constexpr size_t pop_front_until(uint64_t seq) {
+    // sequence numbers wrap around, seq before the first element gives "negative" distance
+    uint64_t n = seq - base_seq;
+    if ((int64_t)n < 0)
+      n = 0;
+    else if (n > _size)
+      n = _size;
+
+    _pop_front_blocks((size_t)n, [](T*, size_t) {});
+    return (size_t)n;
+  }
+
+  /**
+   * Remove n elements from the back of deque
+   * param[in] n number of elements to remove
+   */
+  constexpr void pop_back_n(size_t n) {
+    if (n > _size)
+      throw std::out_of_range("not enough elements");
+
+    size_t left = n;
+    while (left > 0) {
+      if (last_j == 0) {
+        --last_i;
+        last_j = FIXED_ARRAY_SIZE;
+      }
+      size_t count = last_j < left ? last_j : left;
+      _destroy(data[last_i] + last_j - count, count);
+      last_j -= count;
+      left -= count;
+    }
+    _size -= n;
+
+    _shrink_back();
+  }
+
+  /**
+   * Remove elements from the front of deque while they satisfy predicate
+   * param[in] pred predicate taking reference to element
+   * @return number of removed elements
+   */
+  template <typename Predicate>
+  constexpr size_t pop_front_while(Predicate pred) {
+    size_t n = 0;
+    for (size_t k = 0; k < segment_count(); ++k) {
+      std::pair<T*, size_t> seg = segment(k);
+      size_t j = 0;
+      while (j < seg.second && pred(seg.first[j]))
+        ++j;
+      n += j;
+      if (j < seg.second)
+        break;
+    }
+
+    _pop_front_blocks(n, [](T*, size_t) {});
+    return n;
+  }
+
+  /**
+   * Remove all elements satisfying predicate, keeping order of the rest.
+   * Kept elements are moved forward in one pass, run by run, then the tail is destroyed and
+   * emptied fixed-size arrays are freed at once
+   * param[in] pred predicate taking reference to element
+   * @return number of removed elements
+   */
+  template <typename Predicate>
+  constexpr size_t erase_if(Predicate pred) {
+    size_t wi = first_i;
+    size_t wj = first_j;
+    size_t kept = 0;
+    for (size_t k = 0; k < segment_count(); ++k) {
+      std::pair<T*, size_t> seg = segment(k);
+      size_t j = 0;
+      while (j < seg.second) {
+        if (pred(seg.first[j])) {
+          ++j;
+          continue;
+        }
+        size_t end = j + 1;
+        while (end < seg.second && !pred(seg.first[end]))
+          ++end;
+        _compact_run(seg.first + j, end - j, wi, wj);
+        kept += end - j;
+        j = end;
+      }
+    }
+
+    size_t removed = _size - kept;
+    pop_back_n(removed);
+    return removed;
+  }
+
+  /**
+   * Move up to n elements from the front of deque to output iterator and remove them
+   * param[in] n max number of elements to move
+   * param[in] out output iterator
+   * @return output iterator past the last moved element
+   */
+  template <typename OutputIt>
+  constexpr OutputIt drain_front(size_t n, OutputIt out) {
+    _pop_front_blocks(n < _size ? n : _size, [&out](T* first, size_t count) {
+      out = std::move(first, first + count, out);
+    });
+    return out;
   }
 
   /**
    * Remove all elements
    */
-  void clear() noexcept{
+  constexpr void clear() noexcept{
     if (first_i == last_i) {
       for (size_t j = first_j; j < last_j; ++j)
         alloc_traits::destroy(alloc, data[first_i] + j);
@@ -909,14 +1772,109 @@ public:
       for (size_t j = 0; j < last_j; ++j)
         alloc_traits::destroy(alloc, data[last_i] + j);
     }
-    _reduce_size(false, DYNAMIC_ARRAY_START_SIZE);
+    if (realtime) {
+      while (dynamic_arr_size > DYNAMIC_ARRAY_START_SIZE)
+        _release_back_array();
+    }
+    else {
+      _reduce_size(false, DYNAMIC_ARRAY_START_SIZE);
+    }
     first_i = DYNAMIC_ARRAY_START_SIZE / 2;
     first_j = 0;
     last_i = first_i;
     last_j = first_j;
+    base_seq += _size;
     _size = 0;
+    ++generation;
+  }
+
+  /**
+   * Write binary image of deque to stream: header followed by raw elements
+   * @param[in] out output stream
+   * @warning image uses native byte order
+   */
+  void save(std::ostream& out) const {
+    static_assert(std::is_trivially_copyable<T>::value, "save() requires trivially copyable elements");
+
+    binary_header header = { BINARY_MAGIC, BINARY_VERSION, sizeof(T), _size };
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    _for_each_block([&out](T const* block, size_t count) {
+      out.write(reinterpret_cast<char const*>(block), (std::streamsize)(count * sizeof(T)));
+    });
+
+    if (!out)
+      throw std::runtime_error("failed to write deque binary image");
+  }
+
+  /**
+   * Replace deque content with binary image read from stream
+   * @param[in] in input stream positioned at image written by save()
+   */
+  void load(std::istream& in) {
+    static_assert(std::is_trivially_copyable<T>::value, "load() requires trivially copyable elements");
+
+    binary_header header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      throw std::runtime_error("unexpected end of deque binary image");
+    _check_header(header);
+
+    deque tmp(alloc);
+    tmp._prepare_load((size_t)header.count);
+    tmp._for_each_block([&in](T* block, size_t count) {
+      if (!in.read(reinterpret_cast<char*>(block), (std::streamsize)(count * sizeof(T))))
+        throw std::runtime_error("unexpected end of deque binary image");
+    });
+
+    tmp.set_realtime_growth(realtime);
+    *this = std::move(tmp);
+  }
+
+#ifdef DEQUE_HAS_SCATTER_GATHER_IO
+  /**
+   * Write binary image of deque to file descriptor with one writev buffer per fixed-size array
+   * @param[in] fd file descriptor opened for writing
+   * @warning image uses native byte order
+   */
+  void save(int fd) const {
+    static_assert(std::is_trivially_copyable<T>::value, "save() requires trivially copyable elements");
+
+    binary_header header = { BINARY_MAGIC, BINARY_VERSION, sizeof(T), _size };
+    std::vector<struct iovec> iov;
+    iov.reserve(_size / FIXED_ARRAY_SIZE + 3);
+    iov.push_back({ &header, sizeof(header) });
+    _for_each_block([&iov](T const* block, size_t count) {
+      iov.push_back({ const_cast<T*>(block), count * sizeof(T) });
+    });
+
+    _transfer_all(fd, iov.data(), iov.size(), true);
   }
 
+  /**
+   * Replace deque content with binary image read from file descriptor directly into new fixed-size arrays
+   * @param[in] fd file descriptor positioned at image written by save()
+   */
+  void load(int fd) {
+    static_assert(std::is_trivially_copyable<T>::value, "load() requires trivially copyable elements");
+
+    binary_header header;
+    struct iovec header_iov = { &header, sizeof(header) };
+    _transfer_all(fd, &header_iov, 1, false);
+    _check_header(header);
+
+    deque tmp(alloc);
+    tmp._prepare_load((size_t)header.count);
+    std::vector<struct iovec> iov;
+    iov.reserve(tmp.dynamic_arr_size);
+    tmp._for_each_block([&iov](T* block, size_t count) {
+      iov.push_back({ block, count * sizeof(T) });
+    });
+    _transfer_all(fd, iov.data(), iov.size(), false);
+
+    tmp.set_realtime_growth(realtime);
+    *this = std::move(tmp);
+  }
+#endif
+
   /**
    * Friend operator<< to print deque elements 
    * @param[in] out output stream
@@ -930,10 +1888,151 @@ public:
     return out;
   }
   
+  /**
+   * Compare deques element by element, runs of integers, enums and pointers by memcmp
+   * param[in] a the first deque
+   * param[in] b the second deque
+   * @return true if deques have equal sizes and elements
+   */
+  friend constexpr bool operator==(deque const& a, deque const& b) {
+    if (a._size != b._size)
+      return false;
+
+    return _zip_segments(a, b, a._size, [](T const* x, T const* y, size_t n) {
+      if constexpr (deque_detail::bytewise_equal_v<T>) {
+        if (!std::is_constant_evaluated())
+          return std::memcmp(x, y, n * sizeof(T)) == 0;
+      }
+      for (size_t j = 0; j < n; ++j) {
+        if (!(x[j] == y[j]))
+          return false;
+      }
+      return true;
+    });
+  }
+
+  /**
+   * Compare deques lexicographically, runs of unsigned bytes by memcmp
+   * param[in] a the first deque
+   * param[in] b the second deque
+   * @return ordering of the first differing elements or of sizes
+   */
+  friend constexpr auto operator<=>(deque const& a, deque const& b)
+    requires std::three_way_comparable<T>
+  {
+    using ordering = std::compare_three_way_result_t<T>;
+    ordering result = ordering::equivalent;
+    size_t n = a._size < b._size ? a._size : b._size;
+    _zip_segments(a, b, n, [&result](T const* x, T const* y, size_t count) {
+      if constexpr (std::is_same_v<T, unsigned char> || std::is_same_v<T, std::byte> || std::is_same_v<T, char8_t>) {
+        if (!std::is_constant_evaluated()) {
+          int c = std::memcmp(x, y, count);
+          result = c <=> 0;
+          return c == 0;
+        }
+      }
+      for (size_t j = 0; j < count; ++j) {
+        result = x[j] <=> y[j];
+        if (result != 0)
+          return false;
+      }
+      return true;
+    });
+    if (result != 0)
+      return result;
+    return ordering(a._size <=> b._size);
+  }
+
   /**
    * Just destructor 
    */
-  ~deque() {
+  constexpr ~deque() {
     _clear_with_deallocate();
   }
 };
+
+/**
+ * Remove all elements satisfying predicate
+ * param[in] container deque to erase from
+ * param[in] pred predicate taking reference to element
+ * @return number of removed elements
+ */
+template <typename T, typename Allocator, typename Predicate>
+constexpr size_t erase_if(deque<T, Allocator>& container, Predicate pred) {
+  return container.erase_if(pred);
+}
+
+namespace std {
+  /**
+   * @brief Hash of deque.
+   *
+   * Integers, enums and pointers are hashed as one byte stream, 8 bytes at a time,
+   * segment by segment, so the result does not depend on where fixed-size arrays start. Other
+   * elements are hashed with std::hash one by one.
+   */
+  template <typename T, typename Allocator>
+  struct hash<deque<T, Allocator>> {
+    static constexpr uint64_t MULTIPLIER = 0x9e3779b97f4a7c15;  ///< golden ratio mixing multiplier
+
+    /**
+     * Mix one word into hash state
+     * @param[in] h hash state
+     * @param[in] word word to mix
+     * @return new hash state
+     */
+    static uint64_t mix(uint64_t h, uint64_t word) noexcept {
+      h = (h ^ word) * MULTIPLIER;
+      return h ^ (h >> 32);
+    }
+
+    /**
+     * Get hash of deque
+     * @param[in] d deque to hash
+     * @return hash
+     */
+    size_t operator()(deque<T, Allocator> const& d) const noexcept {
+      uint64_t h = d.size();
+      if constexpr (deque_detail::bytewise_equal_v<T>) {
+        uint64_t pending = 0;
+        size_t pending_bytes = 0;
+        for (size_t k = 0; k < d.segment_count(); ++k) {
+          std::pair<T*, size_t> seg = d.segment(k);
+          unsigned char const* bytes = reinterpret_cast<unsigned char const*>(seg.first);
+          size_t count = seg.second * sizeof(T);
+          while (count > 0 && pending_bytes != 0) {
+            pending |= (uint64_t)*bytes++ << (8 * pending_bytes);
+            --count;
+            if (++pending_bytes == sizeof(uint64_t)) {
+              h = mix(h, pending);
+              pending = 0;
+              pending_bytes = 0;
+            }
+          }
+          for (; count >= sizeof(uint64_t); count -= sizeof(uint64_t), bytes += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            h = mix(h, word);
+          }
+          for (; count > 0; --count)
+            pending |= (uint64_t)*bytes++ << (8 * pending_bytes++);
+        }
+        if (pending_bytes != 0)
+          h = mix(h, pending);
+      }
+      else {
+        std::hash<T> element_hash;
+        for (size_t k = 0; k < d.segment_count(); ++k) {
+          std::pair<T*, size_t> seg = d.segment(k);
+          for (size_t j = 0; j < seg.second; ++j)
+            h = mix(h, element_hash(seg.first[j]));
+        }
+      }
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccd;
+      h ^= h >> 33;
+      return (size_t)h;
+    }
+  };
+}
+
+#include "deque_bool.hpp"
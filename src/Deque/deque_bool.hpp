@@ -0,0 +1,440 @@
+/**
+ * @file
+ * @brief Bit-packed deque of bool header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque<bool> specialization storing 64 flags per word
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <bit>
+#include <iterator>
+
+/**
+ * @brief Bit-packed deque of bool.
+ *
+ * Flags are kept in a deque of 64-bit words, so every fixed-size array holds
+ * FIXED_ARRAY_SIZE words. Bits of words out of the deque range are always zero.
+ * @tparam Allocator allocator type
+ */
+template <typename Allocator>
+class deque<bool, Allocator> {
+private:
+  using word_type = uint64_t;
+  using word_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<word_type>;
+
+  static constexpr size_t WORD_BITS = 64;  ///< number of flags in word
+
+  deque<word_type, word_allocator> words;  ///< packed flags
+  size_t offset = 0;                       ///< index of the first flag in the first word
+  size_t _size = 0;                        ///< number of flags in deque
+
+public:
+  /**
+   * @brief Proxy reference to flag
+   */
+  class reference {
+    friend class deque;
+
+  private:
+    word_type* word;  ///< word containing flag
+    word_type mask;   ///< mask of flag in word
+
+    /**
+     * Constructor from word and mask
+     * @param[in] word word containing flag
+     * @param[in] mask mask of flag in word
+     */
+    reference(word_type* word, word_type mask) noexcept : word(word), mask(mask) {}
+
+  public:
+    reference(reference const&) = default;
+
+    /**
+     * Get flag value
+     * @return flag value
+     */
+    operator bool() const noexcept {
+      return (*word & mask) != 0;
+    }
+
+    /**
+     * Set flag value
+     * @param[in] value value to set
+     * @return reference to this proxy
+     */
+    reference& operator=(bool value) noexcept {
+      if (value)
+        *word |= mask;
+      else
+        *word &= ~mask;
+      return *this;
+    }
+
+    /**
+     * Set flag value from other flag
+     * @param[in] other flag to copy value from
+     * @return reference to this proxy
+     */
+    reference& operator=(reference const& other) noexcept {
+      return *this = (bool)other;
+    }
+
+    /**
+     * Invert flag
+     */
+    void flip() noexcept {
+      *word ^= mask;
+    }
+  };
+
+private:
+  /**
+   * @brief deque<bool> iterator class
+   */
+  template <bool IsConst>
+  class common_iterator {
+    friend class deque;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = bool;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = std::conditional_t<IsConst, bool, typename deque::reference>;
+
+  private:
+    deque const* owner = nullptr;  ///< iterated deque
+    size_t pos = 0;                ///< number of position
+
+    /**
+     * Constructor from deque and position
+     * @param[in] owner iterated deque
+     * @param[in] pos number of position
+     */
+    common_iterator(deque const* owner, size_t pos) noexcept : owner(owner), pos(pos) {}
+
+  public:
+    common_iterator() = default;
+
+    reference operator*() const noexcept {
+      return (*owner)[pos];
+    }
+
+    reference operator[](difference_type n) const noexcept {
+      return (*owner)[pos + n];
+    }
+
+    common_iterator& operator++() noexcept {
+      ++pos;
+      return *this;
+    }
+
+    common_iterator operator++(int) noexcept {
+      common_iterator tmp = *this;
+      ++pos;
+      return tmp;
+    }
+
+    common_iterator& operator--() noexcept {
+      --pos;
+      return *this;
+    }
+
+    common_iterator operator--(int) noexcept {
+      common_iterator tmp = *this;
+      --pos;
+      return tmp;
+    }
+
+    common_iterator& operator+=(difference_type n) noexcept {
+      pos += n;
+      return *this;
+    }
+
+    common_iterator& operator-=(difference_type n) noexcept {
+      pos -= n;
+      return *this;
+    }
+
+    common_iterator operator+(difference_type n) const noexcept {
+      return common_iterator(owner, pos + n);
+    }
+
+    friend common_iterator operator+(difference_type n, common_iterator const& it) noexcept {
+      return it + n;
+    }
+
+    common_iterator operator-(difference_type n) const noexcept {
+      return common_iterator(owner, pos - n);
+    }
+
+    difference_type operator-(common_iterator const& other) const noexcept {
+      return (difference_type)pos - (difference_type)other.pos;
+    }
+
+    bool operator==(common_iterator const& other) const noexcept {
+      return pos == other.pos;
+    }
+
+    bool operator!=(common_iterator const& other) const noexcept {
+      return pos != other.pos;
+    }
+
+    bool operator<(common_iterator const& other) const noexcept {
+      return pos < other.pos;
+    }
+
+    bool operator<=(common_iterator const& other) const noexcept {
+      return pos <= other.pos;
+    }
+
+    bool operator>(common_iterator const& other) const noexcept {
+      return pos > other.pos;
+    }
+
+    bool operator>=(common_iterator const& other) const noexcept {
+      return pos >= other.pos;
+    }
+  };
+
+  /**
+   * Find the first set flag starting from global bit index
+   * @param[in] bit index of bit counting from the first word
+   * @return number of position of found flag or size() if there is no such flag
+   */
+  size_t _find_from(size_t bit) const noexcept {
+    size_t end = offset + _size;
+    if (bit >= end)
+      return _size;
+
+    size_t w = bit / WORD_BITS;
+    word_type current = words[w] & (~(word_type)0 << (bit % WORD_BITS));
+    size_t count = words.size();
+    while (current == 0) {
+      if (++w == count)
+        return _size;
+      current = words[w];
+    }
+    return w * WORD_BITS + std::countr_zero(current) - offset;
+  }
+
+public:
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+
+  /*
+   * Begin of deque
+   * @return iterator pointed to the first flag of deque
+   */
+  iterator begin() const noexcept {
+    return iterator(this, 0);
+  }
+
+  /*
+   * End of deque
+   * @return iterator pointed to the next after last flag of deque
+   */
+  iterator end() const noexcept {
+    return iterator(this, _size);
+  }
+
+  /*
+   * Begin of deque
+   * @return const iterator pointed to the first flag of deque
+   */
+  const_iterator cbegin() const noexcept {
+    return const_iterator(this, 0);
+  }
+
+  /*
+   * End of deque
+   * @return const iterator pointed to the next after last flag of deque
+   */
+  const_iterator cend() const noexcept {
+    return const_iterator(this, _size);
+  }
+
+  /**
+   * Constructor of empty deque
+   * param[in] alloc allocator to use in deque
+   */
+  deque(Allocator const& alloc = Allocator()) : words(word_allocator(alloc)) {}
+
+  /**
+   * Constructor of deque with the same flags
+   * param[in] count number of flags
+   * param[in] value value of flags
+   * param[in] alloc allocator to use in deque
+   */
+  deque(size_t count, bool value = false, Allocator const& alloc = Allocator()) : words(word_allocator(alloc)) {
+    for (size_t k = 0; k < count / WORD_BITS; ++k)
+      words.push_back(value ? ~(word_type)0 : 0);
+    if (count % WORD_BITS != 0)
+      words.push_back(value ? ((word_type)1 << (count % WORD_BITS)) - 1 : 0);
+    _size = count;
+  }
+
+  /**
+   * Get flag by number of position
+   * param[in] pos number of position
+   * @return proxy reference to flag at this position
+   * @warning does not throw out of range exception
+   */
+  reference operator[](size_t pos) const noexcept {
+    size_t bit = offset + pos;
+    return reference(&words[bit / WORD_BITS], (word_type)1 << (bit % WORD_BITS));
+  }
+
+  /**
+   * Get flag by number of position
+   * param[in] pos number of position
+   * @return proxy reference to flag at this position
+   */
+  reference at(size_t pos) const {
+    if (pos >= _size)
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get the first flag of deque
+   * @return proxy reference to the first flag of deque
+   */
+  reference front() const noexcept {
+    return (*this)[0];
+  }
+
+  /**
+   * Get last flag of deque
+   * @return proxy reference to the last flag of deque
+   */
+  reference back() const noexcept {
+    return (*this)[_size - 1];
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  /**
+   * Get number of flags in deque
+   * @return number of flags in deque
+   */
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  /**
+   * Get number of set flags
+   * @return number of set flags
+   */
+  size_t count() const noexcept {
+    size_t result = 0;
+    for (size_t k = 0; k < words.segment_count(); ++k) {
+      std::pair<word_type*, size_t> seg = words.segment(k);
+      for (size_t w = 0; w < seg.second; ++w)
+        result += std::popcount(seg.first[w]);
+    }
+    return result;
+  }
+
+  /**
+   * Find the first set flag
+   * @return number of position of the first set flag or size() if there is no such flag
+   */
+  size_t find_first() const noexcept {
+    return _find_from(offset);
+  }
+
+  /**
+   * Find the first set flag after position
+   * @param[in] pos number of position to search after
+   * @return number of position of the found flag or size() if there is no such flag
+   */
+  size_t find_next(size_t pos) const noexcept {
+    return _find_from(offset + pos + 1);
+  }
+
+  /**
+   * Add flag to the end of deque
+   * pram[in] value flag to add
+   */
+  void push_back(bool value) {
+    size_t bit = offset + _size;
+    if (bit % WORD_BITS == 0)
+      words.push_back(0);
+    ++_size;
+    (*this)[_size - 1] = value;
+  }
+
+  /**
+   * Add flag to the front of deque
+   * pram[in] value flag to add
+   */
+  void push_front(bool value) {
+    if (offset == 0) {
+      words.push_front(0);
+      offset = WORD_BITS;
+    }
+    --offset;
+    ++_size;
+    (*this)[0] = value;
+  }
+
+  /**
+   * Remove flag from the back of deque
+   */
+  void pop_back() {
+    (*this)[_size - 1] = false;
+    --_size;
+    if ((offset + _size) % WORD_BITS == 0)
+      words.pop_back();
+    if (_size == 0)
+      clear();
+  }
+
+  /**
+   * Remove flag from the front of deque
+   */
+  void pop_front() {
+    (*this)[0] = false;
+    ++offset;
+    --_size;
+    if (offset == WORD_BITS) {
+      words.pop_front();
+      offset = 0;
+    }
+    if (_size == 0)
+      clear();
+  }
+
+  /**
+   * Remove all flags
+   */
+  void clear() noexcept {
+    words.clear();
+    offset = 0;
+    _size = 0;
+  }
+
+  /**
+   * Friend operator<< to print deque flags
+   * @param[in] out output stream
+   * @param[in] deque deque to output
+   * @return reference to stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, deque const& deque) {
+    for (size_t k = 0; k < deque.size(); ++k)
+      out << (bool)deque[k] << " ";
+    return out;
+  }
+};
@@ -0,0 +1,430 @@
+/**
+ * @file
+ * @brief Memory-mapped deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque whose fixed-size arrays live in a memory-mapped file
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief File-backed deque class.
+ *
+ * Fixed-size arrays (blocks) are slots of a file mapped with MAP_SHARED, so the OS may page cold
+ * blocks out while the blocks at both ends stay resident. Every block records its logical number,
+ * which lets the queue be recovered when the file is opened again. Every operation puts block data in
+ * place first and then changes one 8-byte field of the file header, so a crashed process leaves
+ * either the old or the new state.
+ * @tparam T deque elements type, must be trivially copyable
+ * @tparam BlockBytes size of one block in file including its header, multiple of 64 KiB
+ */
+template <typename T, size_t BlockBytes = (size_t)1 << 20>
+class mapped_deque {
+  static_assert(std::is_trivially_copyable<T>::value, "mapped_deque requires trivially copyable elements");
+  static_assert(BlockBytes % 65536 == 0, "block size must be multiple of 64 KiB");
+
+private:
+  /**
+   * Header of a block slot in file
+   */
+  struct slot_header {
+    int64_t seq;    ///< logical number of the block
+    uint64_t used;  ///< 0 for free slot
+  };
+
+  /**
+   * Header of the file
+   */
+  struct file_header {
+    uint32_t magic;         ///< FILE_MAGIC
+    uint32_t version;       ///< FILE_VERSION
+    uint64_t element_size;  ///< sizeof(T)
+    uint64_t block_bytes;   ///< BlockBytes
+    int64_t front;          ///< logical position of the first element, block front / BLOCK_SIZE holds it
+    int64_t back;           ///< logical position after the last element
+  };
+
+  static constexpr uint32_t FILE_MAGIC = 0x50414d44;  ///< "DMAP" in little-endian
+  static constexpr uint32_t FILE_VERSION = 2;         ///< file format version
+  static constexpr size_t HEADER_BYTES = 65536;       ///< file header region size
+  static constexpr size_t SLOT_HEADER_BYTES = 64;     ///< slot header region size
+  static constexpr size_t BLOCK_SIZE = (BlockBytes - SLOT_HEADER_BYTES) / sizeof(T);  ///< elements per block
+  static constexpr size_t EXTENT_BLOCKS = 64;         ///< number of block slots mapped at once
+  static constexpr size_t EXTENT_BYTES = EXTENT_BLOCKS * BlockBytes;
+
+  static_assert(alignof(T) <= SLOT_HEADER_BYTES, "element alignment is too big");
+  static_assert(BLOCK_SIZE > 0, "element does not fit into block");
+
+  int fd = -1;                           ///< mapped file descriptor
+  file_header* header = nullptr;         ///< mapped file header
+  std::vector<void*> extents;            ///< mapped groups of block slots
+  deque<slot_header*> blocks;            ///< blocks of the deque in logical order
+  std::vector<slot_header*> free_slots;  ///< slots that can be reused
+
+  /**
+   * Get elements of block
+   * @param[in] slot block slot
+   * @return pointer to the first element of block
+   */
+  static T* _elements(slot_header* slot) noexcept {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(slot) + SLOT_HEADER_BYTES);
+  }
+
+  /**
+   * Get logical number of block containing position
+   * @param[in] p logical position
+   * @return logical number of block
+   */
+  static int64_t _block_of(int64_t p) noexcept {
+    int64_t b = (int64_t)BLOCK_SIZE;
+    return p >= 0 ? p / b : -((-p + b - 1) / b);
+  }
+
+  /**
+   * Store field of mapped file after all preceding stores
+   * @param[in] field field in mapped file
+   * @param[in] value new value
+   */
+  template <typename U>
+  static void _commit(U& field, U value) noexcept {
+    std::atomic_ref<U>(field).store(value, std::memory_order_release);
+  }
+
+  /**
+   * Get index of the first element in the first block
+   * @return index in block
+   */
+  size_t _first_j() const noexcept {
+    return (size_t)(header->front - _block_of(header->front) * (int64_t)BLOCK_SIZE);
+  }
+
+  /**
+   * Get number of blocks covering elements
+   * @return number of blocks
+   */
+  size_t _needed() const noexcept {
+    return (size_t)(_block_of(header->back + (int64_t)BLOCK_SIZE - 1) - _block_of(header->front));
+  }
+
+  /**
+   * Throw system error from errno
+   * @param[in] what failed operation
+   */
+  [[noreturn]] static void _throw_errno(char const* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  /**
+   * Map one more group of block slots at the end of file
+   */
+  void _add_extent() {
+    off_t offset = (off_t)(HEADER_BYTES + extents.size() * EXTENT_BYTES);
+    if (::ftruncate(fd, offset + (off_t)EXTENT_BYTES) != 0)
+      _throw_errno("ftruncate");
+    _map_extent(offset);
+  }
+
+  /**
+   * Map group of block slots and put its free slots in free list
+   * @param[in] offset offset of the group in file
+   */
+  void _map_extent(off_t offset) {
+    void* extent = ::mmap(nullptr, EXTENT_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    if (extent == MAP_FAILED)
+      _throw_errno("mmap");
+    extents.push_back(extent);
+
+    for (size_t k = EXTENT_BLOCKS; k-- > 0;) {
+      slot_header* slot = reinterpret_cast<slot_header*>(static_cast<char*>(extent) + k * BlockBytes);
+      if (!slot->used)
+        free_slots.push_back(slot);
+    }
+  }
+
+  /**
+   * Take free block slot
+   * @param[in] seq logical number of the new block
+   * @return block slot
+   */
+  slot_header* _acquire(int64_t seq) {
+    if (free_slots.empty())
+      _add_extent();
+
+    slot_header* slot = free_slots.back();
+    free_slots.pop_back();
+    slot->seq = seq;
+    _commit(slot->used, (uint64_t)1);
+    return slot;
+  }
+
+  /**
+   * Return block slot to free list
+   * @param[in] slot block slot
+   */
+  void _release(slot_header* slot) {
+    slot->used = 0;
+    free_slots.push_back(slot);
+  }
+
+  /**
+   * Give a hint to the OS about block access pattern
+   * @param[in] slot block slot
+   * @param[in] advice madvise advice
+   */
+  static void _advise(slot_header* slot, int advice) noexcept {
+    ::madvise(slot, BlockBytes, advice);
+  }
+
+  /**
+   * Rebuild block order from slot headers after the file was opened
+   */
+  void _recover() {
+    std::vector<std::pair<int64_t, slot_header*>> used;
+    for (void* extent : extents) {
+      for (size_t k = 0; k < EXTENT_BLOCKS; ++k) {
+        slot_header* slot = reinterpret_cast<slot_header*>(static_cast<char*>(extent) + k * BlockBytes);
+        if (slot->used)
+          used.emplace_back(slot->seq, slot);
+      }
+    }
+    std::sort(used.begin(), used.end(),
+              [](std::pair<int64_t, slot_header*> const& a, std::pair<int64_t, slot_header*> const& b) {
+                return a.first < b.first;
+              });
+
+    if (header->back < header->front)
+      throw std::runtime_error("mapped deque file is corrupted");
+
+    int64_t front_seq = _block_of(header->front);
+    size_t needed = _needed();
+    for (std::pair<int64_t, slot_header*> const& block : used) {
+      // blocks outside of the recorded range were taken or given back right before a crash
+      if (block.first < front_seq || block.first >= front_seq + (int64_t)needed) {
+        _release(block.second);
+        continue;
+      }
+      if (block.first != front_seq + (int64_t)blocks.size())
+        throw std::runtime_error("mapped deque file is corrupted");
+      blocks.push_back(block.second);
+    }
+
+    if (blocks.size() != needed)
+      throw std::runtime_error("mapped deque file is corrupted");
+  }
+
+  /**
+   * Unmap file and close it
+   */
+  void _close() noexcept {
+    for (void* extent : extents)
+      ::munmap(extent, EXTENT_BYTES);
+    extents.clear();
+    if (header != nullptr)
+      ::munmap(header, HEADER_BYTES);
+    header = nullptr;
+    if (fd != -1)
+      ::close(fd);
+    fd = -1;
+  }
+
+public:
+  /**
+   * Open deque file or create empty one
+   * @param[in] path path to file
+   */
+  explicit mapped_deque(std::string const& path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+      _throw_errno("open");
+
+    try {
+      struct stat st;
+      if (::fstat(fd, &st) != 0)
+        _throw_errno("fstat");
+
+      bool is_new = st.st_size == 0;
+      if (is_new && ::ftruncate(fd, (off_t)HEADER_BYTES) != 0)
+        _throw_errno("ftruncate");
+      if (!is_new && ((size_t)st.st_size < HEADER_BYTES || ((size_t)st.st_size - HEADER_BYTES) % EXTENT_BYTES != 0))
+        throw std::runtime_error("mapped deque file has wrong size");
+
+      void* mapped = ::mmap(nullptr, HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (mapped == MAP_FAILED)
+        _throw_errno("mmap");
+      header = static_cast<file_header*>(mapped);
+
+      if (is_new) {
+        *header = { FILE_MAGIC, FILE_VERSION, sizeof(T), BlockBytes, 0, 0 };
+        return;
+      }
+
+      if (header->magic != FILE_MAGIC || header->version != FILE_VERSION)
+        throw std::runtime_error("not a mapped deque file");
+      if (header->element_size != sizeof(T) || header->block_bytes != BlockBytes)
+        throw std::runtime_error("mapped deque file layout mismatch");
+
+      size_t extent_count = ((size_t)st.st_size - HEADER_BYTES) / EXTENT_BYTES;
+      for (size_t k = 0; k < extent_count; ++k)
+        _map_extent((off_t)(HEADER_BYTES + k * EXTENT_BYTES));
+      _recover();
+    }
+    catch (...) {
+      _close();
+      throw;
+    }
+  }
+
+  mapped_deque(mapped_deque const&) = delete;
+  mapped_deque& operator=(mapped_deque const&) = delete;
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return reference to element at this position
+   * @warning does not throw out of range exception
+   */
+  T& operator[](size_t pos) const noexcept {
+    size_t p = _first_j() + pos;
+    return _elements(blocks[p / BLOCK_SIZE])[p % BLOCK_SIZE];
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return reference to element at this position
+   */
+  T& at(size_t pos) const {
+    if (pos >= size())
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get the first element of deque
+   * @return reference to the first element of deque
+   */
+  T& front() const noexcept {
+    return (*this)[0];
+  }
+
+  /**
+   * Get last element of deque
+   * @return reference to the last element of deque
+   */
+  T& back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return header->back == header->front;
+  }
+
+  /**
+   * Get number of elements in deque
+   * @return number of elements in deque
+   */
+  size_t size() const noexcept {
+    return (size_t)(header->back - header->front);
+  }
+
+  /**
+   * Add element to the end of deque
+   * pram[in] value element to add
+   */
+  void push_back(T const& value) {
+    size_t p = _first_j() + size();
+    if (p == blocks.size() * BLOCK_SIZE) {
+      blocks.push_back(_acquire(_block_of(header->front) + (int64_t)blocks.size()));
+      // the block behind the tail has become interior, nobody needs it in memory soon
+#ifdef MADV_COLD
+      if (blocks.size() > 2)
+        _advise(blocks[blocks.size() - 2], MADV_COLD);
+#endif
+    }
+
+    _elements(blocks[p / BLOCK_SIZE])[p % BLOCK_SIZE] = value;
+    _commit(header->back, header->back + 1);
+  }
+
+  /**
+   * Add element to the front of deque
+   * pram[in] value element to add
+   */
+  void push_front(T const& value) {
+    size_t j = _first_j();
+    if (j == 0) {
+      blocks.push_front(_acquire(_block_of(header->front) - 1));
+      j = BLOCK_SIZE;
+    }
+
+    _elements(blocks[0])[j - 1] = value;
+    _commit(header->front, header->front - 1);
+  }
+
+  /**
+   * Remove element from the front of deque
+   */
+  void pop_front() {
+    _commit(header->front, header->front + 1);
+    if (_first_j() == 0) {
+      slot_header* slot = blocks.front();
+      blocks.pop_front();
+      _release(slot);
+      // the next block is about to be read
+      if (blocks.size() > 1)
+        _advise(blocks[1], MADV_WILLNEED);
+    }
+  }
+
+  /**
+   * Remove element from the back of deque
+   */
+  void pop_back() {
+    _commit(header->back, header->back - 1);
+    size_t needed = _needed();
+    if (blocks.size() > needed && needed > 0) {
+      slot_header* slot = blocks.back();
+      blocks.pop_back();
+      _release(slot);
+    }
+  }
+
+  /**
+   * Flush mapped file to disk
+   */
+  void sync() const {
+    if (::msync(header, HEADER_BYTES, MS_SYNC) != 0)
+      _throw_errno("msync");
+    for (void* extent : extents) {
+      if (::msync(extent, EXTENT_BYTES, MS_SYNC) != 0)
+        _throw_errno("msync");
+    }
+  }
+
+  /**
+   * Just destructor
+   */
+  ~mapped_deque() {
+    _close();
+  }
+};
@@ -0,0 +1,260 @@
+/**
+ * @file
+ * @brief Min-max heap header file
+ * @authors Pavlov Ilya
+ *
+ * Contains double-ended priority queue adaptor over deque
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <bit>
+#include <functional>
+#include <utility>
+
+/**
+ * @brief Min-max heap class.
+ *
+ * Implicit binary tree stored level by level in container, nodes on even levels are not greater
+ * than their descendants, nodes on odd levels are not less than them. So the minimum is the root,
+ * the maximum is the greatest of the root children, and both ends are removed in O(log n).
+ * @tparam T elements type
+ * @tparam Compare strict weak order of elements
+ * @tparam Container random access container with push_back() and pop_back()
+ */
+template <typename T, typename Compare = std::less<T>, typename Container = deque<T>>
+class minmax_heap {
+private:
+  Container c;   ///< elements level by level
+  Compare comp;  ///< order of elements
+
+  /**
+   * Check if node is on min level
+   * @param[in] i node index
+   * @return true if node is on even level else false
+   */
+  static bool _is_min_level(size_t i) noexcept {
+    return (std::bit_width(i + 1) - 1) % 2 == 0;
+  }
+
+  /**
+   * Compare nodes in order of level kind
+   * @param[in] a the first node index
+   * @param[in] b the second node index
+   * @param[in] min_level true to compare as on min level, false to reverse the order
+   * @return true if node a goes before node b
+   */
+  bool _before(size_t a, size_t b, bool min_level) const {
+    return min_level ? comp(c[a], c[b]) : comp(c[b], c[a]);
+  }
+
+  /**
+   * Swap nodes
+   * @param[in] a the first node index
+   * @param[in] b the second node index
+   */
+  void _swap(size_t a, size_t b) {
+    using std::swap;
+    swap(c[a], c[b]);
+  }
+
+  /**
+   * Move node up among grandparents of the same level kind
+   * @param[in] i node index
+   * @param[in] min_level kind of node level
+   */
+  void _bubble_up_grandparents(size_t i, bool min_level) {
+    while (i > 2) {
+      size_t grandparent = ((i - 1) / 2 - 1) / 2;
+      if (!_before(i, grandparent, min_level))
+        return;
+      _swap(i, grandparent);
+      i = grandparent;
+    }
+  }
+
+  /**
+   * Move new leaf up to its place
+   * @param[in] i node index
+   */
+  void _bubble_up(size_t i) {
+    if (i == 0)
+      return;
+
+    bool min_level = _is_min_level(i);
+    size_t parent = (i - 1) / 2;
+    if (_before(parent, i, min_level)) {
+      _swap(i, parent);
+      _bubble_up_grandparents(parent, !min_level);
+    }
+    else {
+      _bubble_up_grandparents(i, min_level);
+    }
+  }
+
+  /**
+   * Move node down to its place
+   * @param[in] i node index
+   */
+  void _trickle_down(size_t i) {
+    bool min_level = _is_min_level(i);
+    size_t n = c.size();
+    for (;;) {
+      size_t child = 2 * i + 1;
+      if (child >= n)
+        return;
+
+      // the best of at most two children and four grandchildren
+      size_t best = child;
+      if (child + 1 < n && _before(child + 1, best, min_level))
+        best = child + 1;
+      size_t grandchild = 2 * child + 1;
+      for (size_t g = grandchild; g < grandchild + 4 && g < n; ++g) {
+        if (_before(g, best, min_level))
+          best = g;
+      }
+
+      if (!_before(best, i, min_level))
+        return;
+      _swap(best, i);
+      if (best <= child + 1)
+        return;
+
+      size_t parent = (best - 1) / 2;
+      if (_before(parent, best, min_level))
+        _swap(best, parent);
+      i = best;
+    }
+  }
+
+  /**
+   * Get index of the greatest element
+   * @return node index
+   */
+  size_t _max_index() const {
+    if (c.size() < 2)
+      return 0;
+    if (c.size() == 2 || !comp(c[1], c[2]))
+      return 1;
+    return 2;
+  }
+
+  /**
+   * Replace node with the last one and restore heap
+   * @param[in] i node index
+   */
+  void _remove(size_t i) {
+    size_t last = c.size() - 1;
+    if (i != last)
+      c[i] = std::move(c[last]);
+    c.pop_back();
+    if (i < c.size())
+      _trickle_down(i);
+  }
+
+public:
+  /**
+   * Constructor of empty heap
+   * param[in] comp order of elements
+   */
+  explicit minmax_heap(Compare const& comp = Compare()) : comp(comp) {}
+
+  /**
+   * Constructor from range, O(n)
+   * param[in] first begin of range
+   * param[in] last end of range
+   * param[in] comp order of elements
+   */
+  template <typename InputIt>
+  minmax_heap(InputIt first, InputIt last, Compare const& comp = Compare()) : comp(comp) {
+    for (; first != last; ++first)
+      c.push_back(*first);
+    make_heap();
+  }
+
+  /**
+   * Restore heap order of all elements at once, O(n)
+   */
+  void make_heap() {
+    for (size_t i = c.size() / 2; i-- > 0;)
+      _trickle_down(i);
+  }
+
+  /**
+   * Check if heap is empty
+   * @return true if heap is empty else false
+   */
+  bool empty() const noexcept {
+    return c.empty();
+  }
+
+  /**
+   * Get number of elements
+   * @return number of elements
+   */
+  size_t size() const noexcept {
+    return c.size();
+  }
+
+  /**
+   * Get the smallest element
+   * @return const reference to the smallest element
+   * @warning heap must not be empty
+   */
+  T const& min() const {
+    return c[0];
+  }
+
+  /**
+   * Get the greatest element
+   * @return const reference to the greatest element
+   * @warning heap must not be empty
+   */
+  T const& max() const {
+    return c[_max_index()];
+  }
+
+  /**
+   * Add element
+   * pram[in] value element to add
+   */
+  void push(T const& value) {
+    c.push_back(value);
+    _bubble_up(c.size() - 1);
+  }
+
+  /**
+   * Add element
+   * pram[in] value element to add
+   */
+  void push(T&& value) {
+    c.push_back(std::move(value));
+    _bubble_up(c.size() - 1);
+  }
+
+  /**
+   * Remove the smallest element
+   * @warning heap must not be empty
+   */
+  void pop_min() {
+    _remove(0);
+  }
+
+  /**
+   * Remove the greatest element
+   * @warning heap must not be empty
+   */
+  void pop_max() {
+    _remove(_max_index());
+  }
+
+  /**
+   * Get underlying container, elements are in heap order
+   * @return const reference to container
+   */
+  Container const& container() const noexcept {
+    return c;
+  }
+};
@@ -0,0 +1,446 @@
+/**
+ * @file
+ * @brief Parallel deque algorithms header file
+ * @authors Pavlov Ilya
+ *
+ * Contains execution-policy overloads of algorithms partitioned on deque segment boundaries
+ */
+
+#pragma once
+
+#include "deque.hpp"
+#include "thread_pool.hpp"
+
+#include <optional>
+#include <type_traits>
+
+/**
+ * Execution policies of parallel deque algorithms. The work is done by thread_pool, so only the tags
+ * are needed and <execution> with its parallel backend is not pulled in.
+ */
+namespace deque_execution {
+  struct sequenced_policy {};             ///< run in the calling thread
+  struct parallel_policy {};              ///< run in thread pool
+  struct parallel_unsequenced_policy {};  ///< run in thread pool, same as parallel_policy
+
+  inline constexpr sequenced_policy seq{};
+  inline constexpr parallel_policy par{};
+  inline constexpr parallel_unsequenced_policy par_unseq{};
+
+  /**
+   * Check if type is execution policy
+   * @tparam T type to check
+   */
+  template <typename T>
+  inline constexpr bool is_execution_policy_v = std::is_same_v<T, sequenced_policy> ||
+    std::is_same_v<T, parallel_policy> || std::is_same_v<T, parallel_unsequenced_policy>;
+}
+
+namespace deque_detail {
+  inline constexpr size_t PARALLEL_MIN_CHUNK = 16384;      ///< minimal number of elements per parallel task
+  inline constexpr size_t PARALLEL_CHUNKS_PER_THREAD = 4;  ///< tasks per thread for load balancing
+
+  /**
+   * Check if execution policy asks for sequential execution
+   * @tparam ExecutionPolicy execution policy type
+   */
+  template <typename ExecutionPolicy>
+  constexpr bool is_sequenced_v = std::is_same_v<std::decay_t<ExecutionPolicy>, deque_execution::sequenced_policy>;
+
+  /**
+   * Enable overload only for execution policies
+   * @tparam ExecutionPolicy execution policy type
+   */
+  template <typename ExecutionPolicy>
+  using enable_if_policy_t = std::enable_if_t<deque_execution::is_execution_policy_v<std::decay_t<ExecutionPolicy>>, int>;
+
+  /**
+   * Run function over items split into tasks of consecutive items
+   * @param[in] parallel false to run in the calling thread
+   * @param[in] items number of items
+   * @param[in] elements number of elements in all items
+   * @param[in] fn function taking task number, the first item and the item after the last one
+   * @return number of tasks
+   */
+  template <typename Fn>
+  size_t for_each_range(bool parallel, size_t items, size_t elements, Fn&& fn) {
+    if (items == 0)
+      return 0;
+
+    // chunk size grows with deque size, but every thread gets a few chunks to balance the load
+    thread_pool& pool = thread_pool::instance();
+    size_t chunks = 1;
+    if (parallel) {
+      chunks = elements / PARALLEL_MIN_CHUNK;
+      size_t max_chunks = pool.size() * PARALLEL_CHUNKS_PER_THREAD;
+      chunks = chunks < 1 ? 1 : (chunks > max_chunks ? max_chunks : chunks);
+      chunks = chunks > items ? items : chunks;
+    }
+    size_t per_chunk = (items + chunks - 1) / chunks;
+    chunks = (items + per_chunk - 1) / per_chunk;
+
+    auto task = [&](size_t k) {
+      size_t end = (k + 1) * per_chunk < items ? (k + 1) * per_chunk : items;
+      fn(k, k * per_chunk, end);
+    };
+
+    if (chunks == 1)
+      task(0);
+    else
+      pool.run(chunks, task);
+    return chunks;
+  }
+
+  /**
+   * Run function over deque segments split into tasks of whole segments
+   * @param[in] parallel false to run in the calling thread
+   * @param[in] d deque to split
+   * @param[in] fn function taking task number, pointer to segment, its length and its position in deque
+   * @return number of tasks
+   */
+  template <typename T, typename Allocator, typename Fn>
+  size_t for_each_chunk(bool parallel, deque<T, Allocator> const& d, Fn&& fn) {
+    return for_each_range(parallel, d.segment_count(), d.size(), [&](size_t k, size_t begin, size_t end) {
+      for (size_t s = begin; s < end; ++s) {
+        std::pair<T*, size_t> seg = d.segment(s);
+        fn(k, seg.first, seg.second, d.segment_start(s));
+      }
+    });
+  }
+
+  /**
+   * @brief Access to deque storage for parallel construction and destruction.
+   */
+  struct lifecycle_access {
+    /**
+     * Allocate dynamic array and fixed-size arrays
+     * @param[in] parallel false to run in the calling thread
+     * @param[in] d deque without storage
+     * @param[in] count number of fixed-size arrays
+     */
+    template <typename T, typename Allocator>
+    static void allocate(bool parallel, deque<T, Allocator>& d, size_t count) {
+      using traits = typename deque<T, Allocator>::alloc_traits;
+      using ptr_traits = typename deque<T, Allocator>::template ptr_alloc_traits<T>;
+      constexpr size_t block = deque<T, Allocator>::FIXED_ARRAY_SIZE;
+
+      T** data = ptr_traits::allocate(d.ptr_alloc, count);
+      for (size_t i = 0; i < count; ++i)
+        d._set_block(data, i, nullptr);
+
+      // stateful allocators are not assumed to be thread-safe
+      bool concurrent = parallel && traits::is_always_equal::value;
+      try {
+        for_each_range(concurrent, count, count * block, [&](size_t, size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i)
+            data[i] = traits::allocate(d.alloc, block);
+        });
+      }
+      catch (...) {
+        for (size_t i = 0; i < count; ++i) {
+          if (data[i] != nullptr)
+            traits::deallocate(d.alloc, data[i], block);
+        }
+        ptr_traits::deallocate(d.ptr_alloc, data, count);
+        throw;
+      }
+
+      d.data = data;
+      d.dynamic_arr_size = count;
+      d._max_size = count * block;
+    }
+
+    /**
+     * Construct all elements of allocated deque, freeing its storage on exception
+     * @param[in] parallel false to run in the calling thread
+     * @param[in] d deque with allocated storage and set cursors
+     * @param[in] init function taking pointer to memory of element, index in dynamic array and
+     * index in fixed-size array and constructing element
+     */
+    template <typename T, typename Allocator, typename Init>
+    static void construct(bool parallel, deque<T, Allocator>& d, Init&& init) {
+      size_t segments = d.segment_count();
+      std::vector<size_t> built(parallel ? thread_pool::instance().size() * PARALLEL_CHUNKS_PER_THREAD : 1, 0);
+
+      auto walk = [&d](size_t begin, size_t end, size_t limit, auto&& fn) {
+        for (size_t s = begin; s < end && limit > 0; ++s) {
+          std::pair<T*, size_t> seg = d.segment(s);
+          size_t i = d.first_i + s;
+          size_t j = (size_t)(seg.first - d.data[i]);
+          for (size_t t = 0; t < seg.second && limit > 0; ++t, --limit)
+            fn(seg.first + t, i, j + t);
+        }
+      };
+
+      std::vector<std::pair<size_t, size_t>> ranges(built.size());
+      try {
+        for_each_range(parallel, segments, d._size, [&](size_t k, size_t begin, size_t end) {
+          ranges[k] = { begin, end };
+          walk(begin, end, SIZE_MAX, [&](T* slot, size_t i, size_t j) {
+            init(slot, i, j);
+            ++built[k];
+          });
+        });
+      }
+      catch (...) {
+        for (size_t k = 0; k < built.size(); ++k) {
+          walk(ranges[k].first, ranges[k].second, built[k], [&d](T* slot, size_t, size_t) {
+            deque<T, Allocator>::alloc_traits::destroy(d.alloc, slot);
+          });
+        }
+        d._size = 0;
+        d.last_i = d.first_i;
+        d.last_j = d.first_j;
+        d._clear_with_deallocate();
+        throw;
+      }
+    }
+
+    /**
+     * Copy deque with the same layout
+     * @param[in] parallel false to run in the calling thread
+     * @param[in] src deque to copy
+     * @return copy of deque
+     */
+    template <typename T, typename Allocator>
+    static deque<T, Allocator> clone(bool parallel, deque<T, Allocator> const& src) {
+      using traits = typename deque<T, Allocator>::alloc_traits;
+
+      deque<T, Allocator> d(typename deque<T, Allocator>::no_storage(), traits::select_on_container_copy_construction(src.alloc));
+      allocate(parallel, d, src.dynamic_arr_size);
+      d._size = src._size;
+      d.first_i = src.first_i;
+      d.first_j = src.first_j;
+      d.last_i = src.last_i;
+      d.last_j = src.last_j;
+      d.base_seq = src.base_seq;
+      construct(parallel, d, [&src, &d](T* slot, size_t i, size_t j) {
+        traits::construct(d.alloc, slot, src.data[i][j]);
+      });
+
+      if (src.realtime)
+        d.set_realtime_growth(true);
+      return d;
+    }
+
+    /**
+     * Make deque of copies of value
+     * @param[in] parallel false to run in the calling thread
+     * @param[in] count number of elements
+     * @param[in] value value to copy
+     * @param[in] alloc allocator to use in deque
+     * @return deque
+     */
+    template <typename T, typename Allocator>
+    static deque<T, Allocator> filled(bool parallel, size_t count, T const& value, Allocator const& alloc) {
+      using traits = typename deque<T, Allocator>::alloc_traits;
+      constexpr size_t block = deque<T, Allocator>::FIXED_ARRAY_SIZE;
+
+      // the same layout as deque(count, value) has: free fixed-size arrays before the first element
+      size_t first_i = (count / block + 1) / 2;
+      deque<T, Allocator> d(typename deque<T, Allocator>::no_storage(), alloc);
+      allocate(parallel, d, first_i + count / block + 1);
+      d._size = count;
+      d.first_i = first_i;
+      d.first_j = 0;
+      d.last_i = first_i + count / block;
+      d.last_j = count % block;
+      construct(parallel, d, [&value, &d](T* slot, size_t, size_t) {
+        traits::construct(d.alloc, slot, value);
+      });
+      return d;
+    }
+
+    /**
+     * Destroy elements and free storage, leaving deque empty as after clear() without allocating
+     * @param[in] parallel false to run in the calling thread
+     * @param[in] d deque
+     */
+    template <typename T, typename Allocator>
+    static void teardown(bool parallel, deque<T, Allocator>& d) {
+      using traits = typename deque<T, Allocator>::alloc_traits;
+      using ptr_traits = typename deque<T, Allocator>::template ptr_alloc_traits<T>;
+      constexpr size_t block = deque<T, Allocator>::FIXED_ARRAY_SIZE;
+      if (d.data == nullptr)
+        return;
+
+      bool concurrent = parallel && traits::is_always_equal::value;
+      size_t count = d.dynamic_arr_size;
+      for_each_range(parallel, count, d._size, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (i >= d.first_i && i <= d.last_i) {
+            size_t j = i == d.first_i ? d.first_j : 0;
+            size_t stop = i == d.last_i ? d.last_j : block;
+            for (; j < stop; ++j)
+              traits::destroy(d.alloc, d.data[i] + j);
+          }
+          if (concurrent)
+            traits::deallocate(d.alloc, d.data[i], block);
+        }
+      });
+      if (!concurrent) {
+        for (size_t i = 0; i < count; ++i)
+          traits::deallocate(d.alloc, d.data[i], block);
+      }
+
+      // like clear(), keep sequence numbers and mode, but without storage, so nothing is allocated
+      uint64_t seq = d.base_seq + d._size;
+      if (d.realtime) {
+        // real-time mode keeps buffer of dynamic array, it grows inside it
+        if (d.next_buf != nullptr)
+          ptr_traits::deallocate(d.ptr_alloc, d.next_buf, d.next_cap);
+        d.next_buf = nullptr;
+        d.next_cap = 0;
+        d.migrate_lo = 0;
+        d.migrate_hi = 0;
+        d.data = d.map_buf + d.map_cap / 2;
+      }
+      else {
+        ptr_traits::deallocate(d.ptr_alloc, d.data, count);
+        d.data = nullptr;
+      }
+      d._size = 0;
+      d._max_size = 0;
+      d.dynamic_arr_size = 0;
+      d.first_i = 0;
+      d.first_j = 0;
+      d.last_i = 0;
+      d.last_j = 0;
+      d.base_seq = seq;
+      ++d.generation;
+    }
+  };
+}
+
+/**
+ * Apply function to every element of deque
+ * @param[in] policy execution policy
+ * @param[in] d deque
+ * @param[in] f function taking reference to element
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator, typename Function,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_for_each(ExecutionPolicy&&, deque<T, Allocator>& d, Function f) {
+  deque_detail::for_each_chunk(!deque_detail::is_sequenced_v<ExecutionPolicy>, d,
+    [&f](size_t, T* first, size_t count, size_t) {
+      for (size_t k = 0; k < count; ++k)
+        f(first[k]);
+    });
+}
+
+/**
+ * Write results of function applied to elements of source deque to elements of destination deque
+ * @param[in] policy execution policy
+ * @param[in] src source deque
+ * @param[in] dst destination deque, not smaller than source
+ * @param[in] f function taking reference to source element
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator, typename U, typename UAllocator,
+          typename Function, deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_transform(ExecutionPolicy&&, deque<T, Allocator> const& src, deque<U, UAllocator>& dst, Function f) {
+  if (dst.size() < src.size())
+    throw std::out_of_range("destination deque is too small");
+
+  deque_detail::for_each_chunk(!deque_detail::is_sequenced_v<ExecutionPolicy>, src,
+    [&f, &dst](size_t, T* first, size_t count, size_t pos) {
+      auto out = dst.begin() + (std::ptrdiff_t)pos;
+      for (size_t k = 0; k < count; ++k, ++out)
+        *out = f(first[k]);
+    });
+}
+
+/**
+ * Copy elements of source deque to elements of destination deque
+ * @param[in] policy execution policy
+ * @param[in] src source deque
+ * @param[in] dst destination deque, not smaller than source
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator, typename UAllocator,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_copy(ExecutionPolicy&& policy, deque<T, Allocator> const& src, deque<T, UAllocator>& dst) {
+  deque_transform(std::forward<ExecutionPolicy>(policy), src, dst, [](T const& value) -> T const& {
+    return value;
+  });
+}
+
+/**
+ * Assign value to every element of deque
+ * @param[in] policy execution policy
+ * @param[in] d deque
+ * @param[in] value value to assign
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_fill(ExecutionPolicy&&, deque<T, Allocator>& d, T const& value) {
+  deque_detail::for_each_chunk(!deque_detail::is_sequenced_v<ExecutionPolicy>, d,
+    [&value](size_t, T* first, size_t count, size_t) {
+      for (size_t k = 0; k < count; ++k)
+        first[k] = value;
+    });
+}
+
+/**
+ * Reduce deque elements with associative operation
+ * @param[in] policy execution policy
+ * @param[in] d deque
+ * @param[in] init initial value
+ * @param[in] op associative binary operation
+ * @return op(init, op(d[0], op(d[1], ...))) in unspecified grouping
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator, typename U, typename BinaryOp,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+U deque_reduce(ExecutionPolicy&&, deque<T, Allocator> const& d, U init, BinaryOp op) {
+  bool parallel = !deque_detail::is_sequenced_v<ExecutionPolicy>;
+  std::vector<std::optional<U>> partial(parallel ? thread_pool::instance().size() * deque_detail::PARALLEL_CHUNKS_PER_THREAD : 1);
+
+  size_t chunks = deque_detail::for_each_chunk(parallel, d,
+    [&partial, &op](size_t chunk, T* first, size_t count, size_t) {
+      std::optional<U>& acc = partial[chunk];
+      size_t k = 0;
+      if (!acc)
+        acc.emplace(first[k++]);
+      for (; k < count; ++k)
+        acc = op(std::move(*acc), first[k]);
+    });
+
+  for (size_t k = 0; k < chunks; ++k)
+    init = op(std::move(init), std::move(*partial[k]));
+  return init;
+}
+
+/**
+ * Copy deque, constructing elements of fixed-size arrays in parallel
+ * @param[in] policy execution policy
+ * @param[in] src deque to copy
+ * @return copy of deque with the same real-time mode and sequence numbers
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+deque<T, Allocator> deque_clone(ExecutionPolicy&&, deque<T, Allocator> const& src) {
+  return deque_detail::lifecycle_access::clone(!deque_detail::is_sequenced_v<ExecutionPolicy>, src);
+}
+
+/**
+ * Make deque of copies of value, constructing elements of fixed-size arrays in parallel
+ * @param[in] policy execution policy
+ * @param[in] count number of elements
+ * @param[in] value value to copy
+ * @param[in] alloc allocator to use in deque
+ * @return deque
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator = std::allocator<T>,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+deque<T, Allocator> deque_filled(ExecutionPolicy&&, size_t count, T const& value, Allocator const& alloc = Allocator()) {
+  return deque_detail::lifecycle_access::filled(!deque_detail::is_sequenced_v<ExecutionPolicy>, count, value, alloc);
+}
+
+/**
+ * Destroy elements and free fixed-size arrays of deque in parallel, leaving deque empty
+ * @param[in] policy execution policy
+ * @param[in] d deque
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_teardown(ExecutionPolicy&&, deque<T, Allocator>& d) {
+  deque_detail::lifecycle_access::teardown(!deque_detail::is_sequenced_v<ExecutionPolicy>, d);
+}
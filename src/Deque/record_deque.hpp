@@ -0,0 +1,258 @@
+/**
+ * @file
+ * @brief Record deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque of variable-length byte records packed into large blocks
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+/**
+ * @brief Deque of variable-length byte records.
+ *
+ * Every record is stored as 32-bit length followed by its bytes, aligned to 4 bytes, in blocks of
+ * BlockBytes bytes. Record that does not fit into the rest of the last block starts a new one,
+ * record bigger than BlockBytes gets a block of its own. pop_front() releases a block when its last
+ * record is removed, one released block is kept for the next push_back(), so steady queueing does not
+ * allocate.
+ * @tparam BlockBytes size of block in bytes
+ * @tparam Allocator allocator of bytes
+ */
+template <size_t BlockBytes = 1 << 16, typename Allocator = std::allocator<std::byte>>
+class record_deque {
+  static_assert(BlockBytes % alignof(uint32_t) == 0 && BlockBytes >= 2 * sizeof(uint32_t), "bad block size");
+
+private:
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+  /**
+   * Block of records
+   */
+  struct block {
+    std::byte* data = nullptr;  ///< memory of block
+    size_t capacity = 0;        ///< size of block in bytes
+    size_t used = 0;            ///< number of bytes taken by records
+  };
+
+  deque<block> blocks;   ///< blocks in order of records
+  block spare;           ///< released block kept for reuse
+  size_t read_pos = 0;   ///< offset of the first record in the first block
+  size_t _size = 0;      ///< number of records
+  size_t _bytes = 0;     ///< number of payload bytes of all records
+  Allocator alloc;       ///< allocator for blocks
+
+  /**
+   * Get number of bytes record takes in block
+   * @param[in] length record length
+   * @return length with prefix rounded up to alignment
+   */
+  static size_t _footprint(size_t length) noexcept {
+    return (sizeof(uint32_t) + length + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1);
+  }
+
+  /**
+   * Get block for records of at least given size, reusing spare block if possible
+   * @param[in] bytes number of bytes needed
+   * @return empty block
+   */
+  block _take_block(size_t bytes) {
+    if (bytes <= BlockBytes && spare.data != nullptr) {
+      block b = spare;
+      spare = block();
+      return b;
+    }
+
+    block b;
+    b.capacity = bytes < BlockBytes ? BlockBytes : bytes;
+    b.data = alloc_traits::allocate(alloc, b.capacity);
+    return b;
+  }
+
+  /**
+   * Keep block as spare or deallocate it
+   * @param[in] b block not used by records
+   */
+  void _release_block(block b) noexcept {
+    if (b.capacity == BlockBytes && spare.data == nullptr) {
+      b.used = 0;
+      spare = b;
+      return;
+    }
+    alloc_traits::deallocate(alloc, b.data, b.capacity);
+  }
+
+  /**
+   * Read length of record
+   * @param[in] at pointer to record
+   * @return record length
+   */
+  static uint32_t _length(std::byte const* at) noexcept {
+    uint32_t length;
+    std::memcpy(&length, at, sizeof(length));
+    return length;
+  }
+
+public:
+  /**
+   * Constructor of empty deque
+   * param[in] alloc allocator to use
+   */
+  record_deque(Allocator const& alloc = Allocator()) : alloc(alloc) {}
+
+  /**
+   * Copy constructor
+   * param[in] other deque to copy
+   */
+  record_deque(record_deque const& other)
+      : alloc(alloc_traits::select_on_container_copy_construction(other.alloc)) {
+    other.for_each([this](std::span<std::byte const> record) { push_back(record); });
+  }
+
+  record_deque& operator=(record_deque const&) = delete;
+
+  /**
+   * Get the first record
+   * @return bytes of the first record
+   * @warning deque must not be empty
+   */
+  std::span<std::byte const> front() const noexcept {
+    std::byte const* at = blocks[0].data + read_pos;
+    return std::span<std::byte const>(at + sizeof(uint32_t), _length(at));
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  /**
+   * Get number of records
+   * @return number of records
+   */
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  /**
+   * Get number of payload bytes of all records
+   * @return number of bytes
+   */
+  size_t bytes() const noexcept {
+    return _bytes;
+  }
+
+  /**
+   * Get number of blocks holding records
+   * @return number of blocks
+   */
+  size_t block_count() const noexcept {
+    return blocks.size();
+  }
+
+  /**
+   * Call function for every record from the first to the last
+   * @param[in] f function taking span of record bytes
+   */
+  template <typename Function>
+  void for_each(Function f) const {
+    for (size_t k = 0; k < blocks.size(); ++k) {
+      block const& b = blocks[k];
+      for (size_t pos = k == 0 ? read_pos : 0; pos < b.used;) {
+        uint32_t length = _length(b.data + pos);
+        f(std::span<std::byte const>(b.data + pos + sizeof(uint32_t), length));
+        pos += _footprint(length);
+      }
+    }
+  }
+
+  /**
+   * Copy record to the end of deque
+   * pram[in] record bytes of record
+   */
+  void push_back(std::span<std::byte const> record) {
+    if (record.size() > UINT32_MAX)
+      throw std::length_error("record is too long");
+
+    size_t need = _footprint(record.size());
+    if (_size == 0 && !blocks.empty() && need > blocks.back().capacity) {
+      // drained deque keeps its only block empty, give it back instead of leaving it in front
+      _release_block(blocks.back());
+      blocks.pop_back();
+      read_pos = 0;
+    }
+    if (blocks.empty() || blocks.back().used + need > blocks.back().capacity) {
+      block b = _take_block(need);
+      try {
+        blocks.push_back(b);
+      }
+      catch (...) {
+        _release_block(b);
+        throw;
+      }
+    }
+
+    block& b = blocks.back();
+    uint32_t length = (uint32_t)record.size();
+    std::memcpy(b.data + b.used, &length, sizeof(length));
+    if (!record.empty())
+      std::memcpy(b.data + b.used + sizeof(uint32_t), record.data(), record.size());
+    b.used += need;
+    ++_size;
+    _bytes += record.size();
+  }
+
+  /**
+   * Remove the first record
+   * @warning deque must not be empty
+   */
+  void pop_front() {
+    uint32_t length = _length(blocks[0].data + read_pos);
+    read_pos += _footprint(length);
+    --_size;
+    _bytes -= length;
+
+    if (read_pos < blocks[0].used)
+      return;
+
+    if (blocks.size() == 1) {
+      blocks[0].used = 0;
+    }
+    else {
+      block b = blocks[0];
+      blocks.pop_front();
+      _release_block(b);
+    }
+    read_pos = 0;
+  }
+
+  /**
+   * Remove all records
+   */
+  void clear() noexcept {
+    for (size_t k = 0; k < blocks.size(); ++k)
+      _release_block(blocks[k]);
+    blocks.clear();
+    read_pos = 0;
+    _size = 0;
+    _bytes = 0;
+  }
+
+  /**
+   * Just destructor
+   */
+  ~record_deque() {
+    clear();
+    if (spare.data != nullptr)
+      alloc_traits::deallocate(alloc, spare.data, spare.capacity);
+  }
+};
@@ -0,0 +1,543 @@
+/**
+ * @file
+ * @brief Shared-memory deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains bounded deque living in POSIX shared memory for exchanging data between processes (Linux only)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Self-relative pointer.
+ *
+ * Stores distance from itself to the target, so it stays valid in every process mapping the
+ * segment, wherever the segment is mapped.
+ * @tparam T type of target
+ */
+template <typename T>
+class offset_ptr {
+private:
+  std::ptrdiff_t offset = 0;  ///< distance in bytes from this object to target, 0 for nullptr
+
+public:
+  offset_ptr() noexcept = default;
+  offset_ptr(offset_ptr const&) = delete;
+  offset_ptr& operator=(offset_ptr const&) = delete;
+
+  /**
+   * Point to target
+   * @param[in] target target in the same segment or nullptr
+   */
+  void set(T* target) noexcept {
+    offset = target == nullptr ? 0 : reinterpret_cast<char*>(target) - reinterpret_cast<char*>(this);
+  }
+
+  /**
+   * Get target
+   * @return pointer to target in this process
+   */
+  T* get() const noexcept {
+    if (offset == 0)
+      return nullptr;
+    return reinterpret_cast<T*>(const_cast<char*>(reinterpret_cast<char const*>(this)) + offset);
+  }
+};
+
+/**
+ * @brief Bounded deque in POSIX shared memory.
+ *
+ * Header, dynamic array and fixed-size arrays are one shm segment, the dynamic array and the header
+ * refer to them with offset pointers. Fixed-size arrays form a ring: position p lives in slot
+ * p % capacity(). Every slot has a sequence number, p when it is free for position p and p + 1 when
+ * element at position p is committed, so producers and the consumer never lock. One consumer and
+ * one (single_producer) or many producers are supported; blocking calls sleep on futexes in the
+ * segment.
+ *
+ * Producers can reserve() a slot, fill it in place and commit() it, the consumer reads committed
+ * elements in place through front(), so elements are never copied through the kernel. If producer
+ * dies between reserve() and commit(), recover() skips its slot. The consumer keeps its position in
+ * the segment, so a restarted consumer continues where the dead one stopped, even if it died while
+ * releasing a slot.
+ * @tparam T elements type, must be trivially copyable
+ * @tparam BlockSize number of slots in fixed-size array
+ */
+template <typename T, size_t BlockSize = 256>
+class shm_deque {
+  static_assert(std::is_trivially_copyable<T>::value, "shm_deque requires trivially copyable elements");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "shm_deque requires lock-free atomics");
+
+private:
+  /**
+   * Element with its state
+   */
+  struct slot {
+    std::atomic<uint64_t> seq;      ///< p if free for position p, p + 1 if element at position p is committed
+    std::atomic<int32_t> owner;     ///< process that reserved slot, 0 if none
+    std::atomic<uint32_t> skipped;  ///< 1 if reservation was abandoned by dead process
+    T value;                        ///< element
+  };
+
+  /**
+   * Header of the segment
+   */
+  struct segment_header {
+    std::atomic<uint32_t> magic;         ///< SEGMENT_MAGIC when segment is initialized
+    uint32_t version;                    ///< SEGMENT_VERSION
+    uint64_t element_size;               ///< sizeof(T)
+    uint64_t block_size;                 ///< BlockSize
+    uint64_t block_count;                ///< number of fixed-size arrays
+    uint64_t single_producer;            ///< 1 if only one producer is allowed
+    offset_ptr<offset_ptr<slot>> map;    ///< dynamic array of fixed-size arrays
+
+    alignas(64) std::atomic<uint64_t> head;         ///< position of the first element, consumer only
+    std::atomic<uint32_t> items;                    ///< futex bumped when element is committed
+    std::atomic<uint32_t> consumer_waiting;         ///< 1 if consumer sleeps on items
+    alignas(64) std::atomic<uint64_t> tail;         ///< position after the last reserved element
+    std::atomic<uint32_t> space;                    ///< futex bumped when slot is freed
+    std::atomic<uint32_t> producers_waiting;        ///< number of producers sleeping on space
+  };
+
+  static constexpr uint32_t SEGMENT_MAGIC = 0x4d485344;  ///< "DSHM" in little-endian
+  static constexpr uint32_t SEGMENT_VERSION = 1;         ///< segment format version
+  static constexpr long WAIT_NS = 100000000;             ///< sleep limit of blocking calls, ns
+
+  segment_header* header = nullptr;  ///< mapped segment
+  size_t mapped_bytes = 0;           ///< size of mapped segment
+  size_t _capacity = 0;              ///< number of slots
+
+  /**
+   * Throw system error from errno
+   * @param[in] what failed operation
+   */
+  [[noreturn]] static void _throw_errno(char const* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  /**
+   * Round up to cache line
+   * @param[in] bytes number of bytes
+   * @return rounded number of bytes
+   */
+  static size_t _align(size_t bytes) noexcept {
+    return (bytes + 63) & ~(size_t)63;
+  }
+
+  /**
+   * Get size of segment
+   * @param[in] block_count number of fixed-size arrays
+   * @return size in bytes
+   */
+  static size_t _segment_bytes(size_t block_count) noexcept {
+    return _align(sizeof(segment_header)) + _align(block_count * sizeof(offset_ptr<slot>)) +
+           block_count * BlockSize * sizeof(slot);
+  }
+
+  /**
+   * Sleep while futex word has expected value
+   * @param[in] word futex word
+   * @param[in] expected value seen before checking condition
+   * @return false if sleep timed out
+   */
+  static bool _wait(std::atomic<uint32_t>& word, uint32_t expected) noexcept {
+    timespec timeout = { 0, WAIT_NS };
+    long r = ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+    return !(r == -1 && errno == ETIMEDOUT);
+  }
+
+  /**
+   * Bump futex word and wake all sleepers
+   * @param[in] word futex word
+   */
+  static void _wake(std::atomic<uint32_t>& word) noexcept {
+    word.fetch_add(1, std::memory_order_release);
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  /**
+   * Get slot of position
+   * @param[in] pos position
+   * @return reference to slot
+   */
+  slot& _slot(uint64_t pos) const noexcept {
+    size_t index = (size_t)(pos % _capacity);
+    return header->map.get()[index / BlockSize].get()[index % BlockSize];
+  }
+
+  /**
+   * Map shm object
+   * @param[in] fd shm object descriptor
+   * @param[in] bytes size to map
+   */
+  void _map(int fd, size_t bytes) {
+    void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+      _throw_errno("mmap");
+    header = static_cast<segment_header*>(mapped);
+    mapped_bytes = bytes;
+  }
+
+  /**
+   * Make slot free for the next lap and wake producers
+   * @param[in] s slot of the first element
+   * @param[in] pos position of the first element
+   */
+  void _release(slot& s, uint64_t pos) noexcept {
+    s.owner.store(0, std::memory_order_relaxed);
+    s.skipped.store(0, std::memory_order_relaxed);
+    s.seq.store(pos + _capacity, std::memory_order_release);
+    header->head.store(pos + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->producers_waiting.load(std::memory_order_relaxed) != 0)
+      _wake(header->space);
+  }
+
+  /**
+   * Move head past slot released by consumer that died before moving head
+   */
+  void _resume_head() noexcept {
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    bool moved = false;
+    while (_slot(head).seq.load(std::memory_order_acquire) >= head + _capacity) {
+      // compare exchange: a live consumer may move head at the same time
+      if (header->head.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel)) {
+        ++head;
+        moved = true;
+      }
+    }
+    if (moved)
+      _wake(header->space);
+  }
+
+public:
+  /**
+   * @brief Reserved slot.
+   */
+  struct reservation {
+    T* value = nullptr;  ///< element to fill, nullptr if deque was full
+    uint64_t pos = 0;    ///< position of element
+
+    explicit operator bool() const noexcept {
+      return value != nullptr;
+    }
+  };
+
+  /**
+   * Create shm object with empty deque
+   * @param[in] name shm object name, starting with '/'
+   * @param[in] capacity min number of slots
+   * @param[in] single_producer true if only one process pushes at a time
+   */
+  shm_deque(std::string const& name, size_t capacity, bool single_producer = false) {
+    size_t block_count = (capacity + BlockSize - 1) / BlockSize;
+    if (block_count == 0)
+      block_count = 1;
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1)
+      _throw_errno("shm_open");
+    try {
+      size_t bytes = _segment_bytes(block_count);
+      if (::ftruncate(fd, (off_t)bytes) != 0)
+        _throw_errno("ftruncate");
+      _map(fd, bytes);
+    }
+    catch (...) {
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      throw;
+    }
+    ::close(fd);
+
+    _capacity = block_count * BlockSize;
+    header = new (header) segment_header();
+    header->version = SEGMENT_VERSION;
+    header->element_size = sizeof(T);
+    header->block_size = BlockSize;
+    header->block_count = block_count;
+    header->single_producer = single_producer ? 1 : 0;
+
+    char* base = reinterpret_cast<char*>(header);
+    offset_ptr<slot>* map = new (base + _align(sizeof(segment_header))) offset_ptr<slot>[block_count];
+    slot* blocks = reinterpret_cast<slot*>(base + _align(sizeof(segment_header)) + _align(block_count * sizeof(offset_ptr<slot>)));
+    header->map.set(map);
+    for (size_t b = 0; b < block_count; ++b) {
+      map[b].set(blocks + b * BlockSize);
+      for (size_t j = 0; j < BlockSize; ++j) {
+        slot* s = new (blocks + b * BlockSize + j) slot;
+        s->seq.store(b * BlockSize + j, std::memory_order_relaxed);
+        s->owner.store(0, std::memory_order_relaxed);
+        s->skipped.store(0, std::memory_order_relaxed);
+      }
+    }
+    header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+  }
+
+  /**
+   * Open existing shm object
+   * @param[in] name shm object name
+   */
+  explicit shm_deque(std::string const& name) {
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd == -1)
+      _throw_errno("shm_open");
+    try {
+      struct stat st;
+      if (::fstat(fd, &st) != 0)
+        _throw_errno("fstat");
+      if ((size_t)st.st_size < sizeof(segment_header))
+        throw std::runtime_error("shm deque segment has wrong size");
+      _map(fd, (size_t)st.st_size);
+    }
+    catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+
+    try {
+      if (header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC || header->version != SEGMENT_VERSION)
+        throw std::runtime_error("not a shm deque segment");
+      if (header->element_size != sizeof(T) || header->block_size != BlockSize)
+        throw std::runtime_error("shm deque segment layout mismatch");
+      if (_segment_bytes(header->block_count) != mapped_bytes)
+        throw std::runtime_error("shm deque segment has wrong size");
+    }
+    catch (...) {
+      ::munmap(header, mapped_bytes);
+      throw;
+    }
+    _capacity = header->block_count * BlockSize;
+    _resume_head();
+  }
+
+  shm_deque(shm_deque const&) = delete;
+  shm_deque& operator=(shm_deque const&) = delete;
+
+  /**
+   * Remove shm object name, mapped segments stay valid
+   * @param[in] name shm object name
+   */
+  static void unlink(std::string const& name) noexcept {
+    ::shm_unlink(name.c_str());
+  }
+
+  /**
+   * Get number of slots
+   * @return number of slots
+   */
+  size_t capacity() const noexcept {
+    return _capacity;
+  }
+
+  /**
+   * Get number of reserved and committed elements, may be outdated at once
+   * @return number of elements
+   */
+  size_t size() const noexcept {
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    return tail > head ? (size_t)(tail - head) : 0;
+  }
+
+  /**
+   * Reserve slot at the end of deque without waiting, producer only
+   * @return reservation, empty if deque is full
+   */
+  reservation try_reserve() noexcept {
+    uint64_t pos = header->tail.load(std::memory_order_relaxed);
+    for (;;) {
+      slot& s = _slot(pos);
+      uint64_t seq = s.seq.load(std::memory_order_acquire);
+      if (seq == pos) {
+        if (header->single_producer) {
+          header->tail.store(pos + 1, std::memory_order_relaxed);
+          break;
+        }
+        if (header->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (seq < pos) {
+        return reservation();
+      }
+      else {
+        pos = header->tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot& s = _slot(pos);
+    s.owner.store((int32_t)::getpid(), std::memory_order_relaxed);
+    return reservation{ &s.value, pos };
+  }
+
+  /**
+   * Reserve slot at the end of deque, waiting while deque is full, producer only
+   * @return reservation
+   */
+  reservation reserve() noexcept {
+    for (;;) {
+      reservation r = try_reserve();
+      if (r)
+        return r;
+
+      header->producers_waiting.fetch_add(1, std::memory_order_seq_cst);
+      uint32_t seen = header->space.load(std::memory_order_acquire);
+      r = try_reserve();
+      if (!r)
+        _wait(header->space, seen);
+      header->producers_waiting.fetch_sub(1, std::memory_order_relaxed);
+      if (r)
+        return r;
+    }
+  }
+
+  /**
+   * Make reserved element visible to consumer
+   * @param[in] r reservation
+   */
+  void commit(reservation const& r) noexcept {
+    _slot(r.pos).seq.store(r.pos + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->consumer_waiting.load(std::memory_order_relaxed) != 0)
+      _wake(header->items);
+  }
+
+  /**
+   * Add element to the end of deque without waiting, producer only
+   * @param[in] value element to add
+   * @return false if deque is full
+   */
+  bool try_push(T const& value) noexcept {
+    reservation r = try_reserve();
+    if (!r)
+      return false;
+    *r.value = value;
+    commit(r);
+    return true;
+  }
+
+  /**
+   * Add element to the end of deque, waiting while deque is full, producer only
+   * pram[in] value element to add
+   */
+  void push_back(T const& value) noexcept {
+    reservation r = reserve();
+    *r.value = value;
+    commit(r);
+  }
+
+  /**
+   * Get the first committed element in place, consumer only
+   * @return pointer to the first element or nullptr if it is not committed yet
+   */
+  T const* front() noexcept {
+    for (;;) {
+      uint64_t pos = header->head.load(std::memory_order_relaxed);
+      slot& s = _slot(pos);
+      if (s.seq.load(std::memory_order_acquire) != pos + 1)
+        return nullptr;
+      if (!s.skipped.load(std::memory_order_relaxed))
+        return &s.value;
+      _release(s, pos);
+    }
+  }
+
+  /**
+   * Remove the first element, consumer only
+   * @warning front() must have returned element
+   */
+  void pop_front() noexcept {
+    uint64_t pos = header->head.load(std::memory_order_relaxed);
+    _release(_slot(pos), pos);
+  }
+
+  /**
+   * Take the first element without waiting, consumer only
+   * @param[out] value the first element
+   * @return false if there is no committed element
+   */
+  bool try_pop(T& value) noexcept {
+    T const* first = front();
+    if (first == nullptr)
+      return false;
+    value = *first;
+    pop_front();
+    return true;
+  }
+
+  /**
+   * Take the first element, waiting for it, consumer only
+   * Reservations of dead producers are skipped while waiting.
+   * @return the first element
+   */
+  T pop() noexcept {
+    T value;
+    for (;;) {
+      if (try_pop(value))
+        return value;
+
+      header->consumer_waiting.store(1, std::memory_order_seq_cst);
+      uint32_t seen = header->items.load(std::memory_order_acquire);
+      bool ready = front() != nullptr;
+      bool woken = ready || _wait(header->items, seen);
+      header->consumer_waiting.store(0, std::memory_order_relaxed);
+      if (!woken)
+        recover();
+    }
+  }
+
+  /**
+   * Skip slots reserved by processes that exited without commit and slot released by consumer that
+   * died before moving head, consumer only
+   * @return number of skipped slots
+   * @warning reservation of producer dying right after taking position and before recording itself
+   * as slot owner is not detected
+   */
+  size_t recover() noexcept {
+    _resume_head();
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    size_t skipped = 0;
+    for (uint64_t pos = head; pos < tail; ++pos) {
+      slot& s = _slot(pos);
+      if (s.seq.load(std::memory_order_acquire) != pos)
+        continue;
+      int32_t owner = s.owner.load(std::memory_order_relaxed);
+      if (owner == 0 || ::kill(owner, 0) == 0 || errno != ESRCH)
+        continue;
+
+      s.skipped.store(1, std::memory_order_relaxed);
+      s.seq.store(pos + 1, std::memory_order_release);
+      ++skipped;
+    }
+    return skipped;
+  }
+
+  /**
+   * Just destructor, unmaps segment
+   */
+  ~shm_deque() {
+    if (header != nullptr)
+      ::munmap(header, mapped_bytes);
+  }
+};
@@ -0,0 +1,172 @@
+/**
+ * @file
+ * @brief Sliding window header file
+ * @authors Pavlov Ilya
+ *
+ * Contains sliding window aggregate adaptor built on deque
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <optional>
+
+/**
+ * @brief Minimum operation for sliding window.
+ * @tparam T elements type
+ */
+template <typename T>
+struct min_op {
+  T const& operator()(T const& a, T const& b) const {
+    return b < a ? b : a;
+  }
+};
+
+/**
+ * @brief Maximum operation for sliding window.
+ * @tparam T elements type
+ */
+template <typename T>
+struct max_op {
+  T const& operator()(T const& a, T const& b) const {
+    return a < b ? b : a;
+  }
+};
+
+/**
+ * @brief Sliding window with aggregate over its elements.
+ *
+ * Window is kept as two stacks inside one deque: the oldest elements have precomputed suffix
+ * aggregates, the newest elements have one running aggregate. When the old part runs out,
+ * aggregates are rebuilt over the whole window, so push, evict and query are amortized O(1).
+ * @tparam T window elements type
+ * @tparam Op associative binary operation
+ */
+template <typename T, typename Op>
+class sliding_window {
+private:
+  deque<T> items;             ///< window elements from the oldest to the newest
+  deque<T> front_aggs;        ///< front_aggs[k] is aggregate of items[k..front_aggs.size() - 1]
+  std::optional<T> back_agg;  ///< aggregate of items after the first front_aggs.size() ones
+  Op op;                      ///< aggregate operation
+
+  /**
+   * Move all window elements to the old part and compute their suffix aggregates
+   */
+  void _rebuild() {
+    front_aggs.clear();
+    if (items.empty())
+      return;
+
+    auto it = items.end();
+    --it;
+    T acc = *it;
+    front_aggs.push_front(acc);
+    while (it != items.begin()) {
+      --it;
+      acc = op(*it, acc);
+      front_aggs.push_front(acc);
+    }
+    back_agg.reset();
+  }
+
+public:
+  /**
+   * Constructor of empty window
+   * @param[in] op aggregate operation
+   */
+  explicit sliding_window(Op const& op = Op()) : op(op) {}
+
+  /**
+   * Add element to the window
+   * @param[in] value element to add
+   */
+  void push(T const& value) {
+    items.push_back(value);
+    if (back_agg)
+      back_agg = op(*back_agg, value);
+    else
+      back_agg = value;
+  }
+
+  /**
+   * Add range of elements to the window
+   * @param[in] first begin of range
+   * @param[in] last end of range
+   */
+  template <typename InputIt>
+  void push_range(InputIt first, InputIt last) {
+    for (; first != last; ++first)
+      push(*first);
+  }
+
+  /**
+   * Remove the oldest element from the window
+   */
+  void evict() {
+    if (items.empty())
+      throw std::out_of_range("window is empty");
+
+    if (front_aggs.empty())
+      _rebuild();
+    items.pop_front();
+    front_aggs.pop_front();
+  }
+
+  /**
+   * Get aggregate of all window elements
+   * @return aggregate value
+   */
+  T query() const {
+    if (items.empty())
+      throw std::out_of_range("window is empty");
+
+    if (front_aggs.empty())
+      return *back_agg;
+    if (!back_agg)
+      return front_aggs.front();
+    return op(front_aggs.front(), *back_agg);
+  }
+
+  /**
+   * Get the oldest element of the window
+   * @return reference to the oldest element
+   */
+  T const& front() const noexcept {
+    return items.front();
+  }
+
+  /**
+   * Get the newest element of the window
+   * @return reference to the newest element
+   */
+  T const& back() const noexcept {
+    return items.back();
+  }
+
+  /**
+   * Check if window is empty
+   * @return true if window is empty else false
+   */
+  bool empty() const noexcept {
+    return items.empty();
+  }
+
+  /**
+   * Get number of elements in window
+   * @return number of elements in window
+   */
+  size_t size() const noexcept {
+    return items.size();
+  }
+
+  /**
+   * Remove all elements
+   */
+  void clear() {
+    items.clear();
+    front_aggs.clear();
+    back_agg.reset();
+  }
+};
@@ -0,0 +1,210 @@
+/**
+ * @file
+ * @brief Structure-of-arrays deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque storing every field of aggregate elements in its own fixed-size arrays
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <tuple>
+#include <utility>
+
+/**
+ * @brief Structure-of-arrays deque class.
+ *
+ * Every field is kept in its own deque. All of them are changed by the same operations in the same
+ * order, so they always have the same layout of fixed-size arrays and cursors, and a scan of one
+ * field reads only that field's memory.
+ * @tparam Fields types of element fields
+ */
+template <typename... Fields>
+class soa_deque {
+public:
+  using value_type = std::tuple<Fields...>;  ///< element type
+  using reference = std::tuple<Fields&...>;  ///< proxy reference to element fields
+
+private:
+  using indexes = std::index_sequence_for<Fields...>;
+
+  std::tuple<deque<Fields>...> columns;  ///< deque per field
+
+  /**
+   * Add element to the back of every column, rolling back on exception
+   */
+  template <size_t... I, typename... Args>
+  void _push_back(std::index_sequence<I...>, Args&&... values) {
+    size_t done = 0;
+    try {
+      ((std::get<I>(columns).push_back(std::forward<Args>(values)), ++done), ...);
+    }
+    catch (...) {
+      ((I < done ? std::get<I>(columns).pop_back() : void()), ...);
+      throw;
+    }
+  }
+
+  /**
+   * Add element to the front of every column, rolling back on exception
+   */
+  template <size_t... I, typename... Args>
+  void _push_front(std::index_sequence<I...>, Args&&... values) {
+    size_t done = 0;
+    try {
+      ((std::get<I>(columns).push_front(std::forward<Args>(values)), ++done), ...);
+    }
+    catch (...) {
+      ((I < done ? std::get<I>(columns).pop_front() : void()), ...);
+      throw;
+    }
+  }
+
+  /**
+   * Collect references to fields of element
+   */
+  template <size_t... I>
+  reference _at(std::index_sequence<I...>, size_t pos) const noexcept {
+    return reference(std::get<I>(columns)[pos]...);
+  }
+
+public:
+  /**
+   * Constructor of empty deque
+   */
+  soa_deque() = default;
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return tuple of references to element fields
+   * @warning does not throw out of range exception
+   */
+  reference operator[](size_t pos) const noexcept {
+    return _at(indexes(), pos);
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return tuple of references to element fields
+   */
+  reference at(size_t pos) const {
+    if (pos >= size())
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get the first element of deque
+   * @return tuple of references to element fields
+   */
+  reference front() const noexcept {
+    return (*this)[0];
+  }
+
+  /**
+   * Get last element of deque
+   * @return tuple of references to element fields
+   */
+  reference back() const noexcept {
+    return (*this)[size() - 1];
+  }
+
+  /**
+   * Get field of every element
+   * @tparam I field number
+   * @return reference to deque of the field
+   */
+  template <size_t I>
+  auto const& column() const noexcept {
+    return std::get<I>(columns);
+  }
+
+  /**
+   * Get contiguous parts of field column for vectorized scans
+   * @tparam I field number
+   * @return pointers to the first field value of every part with number of values in it
+   */
+  template <size_t I>
+  auto segments() const {
+    auto const& col = std::get<I>(columns);
+    std::vector<std::pair<std::tuple_element_t<I, value_type>*, size_t>> result;
+    result.reserve(col.segment_count());
+    for (size_t k = 0; k < col.segment_count(); ++k)
+      result.push_back(col.segment(k));
+    return result;
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return std::get<0>(columns).empty();
+  }
+
+  /**
+   * Get number of elements in deque
+   * @return number of elements in deque
+   */
+  size_t size() const noexcept {
+    return std::get<0>(columns).size();
+  }
+
+  /**
+   * Add element to the end of deque
+   * pram[in] values element fields
+   */
+  void push_back(Fields const&... values) {
+    _push_back(indexes(), values...);
+  }
+
+  /**
+   * Add element to the end of deque
+   * pram[in] value element
+   */
+  void push_back(value_type const& value) {
+    std::apply([this](Fields const&... values) { push_back(values...); }, value);
+  }
+
+  /**
+   * Add element to the front of deque
+   * pram[in] values element fields
+   */
+  void push_front(Fields const&... values) {
+    _push_front(indexes(), values...);
+  }
+
+  /**
+   * Add element to the front of deque
+   * pram[in] value element
+   */
+  void push_front(value_type const& value) {
+    std::apply([this](Fields const&... values) { push_front(values...); }, value);
+  }
+
+  /**
+   * Remove element from the back of deque
+   */
+  void pop_back() {
+    std::apply([](deque<Fields>&... col) { (col.pop_back(), ...); }, columns);
+  }
+
+  /**
+   * Remove element from the front of deque
+   */
+  void pop_front() {
+    std::apply([](deque<Fields>&... col) { (col.pop_front(), ...); }, columns);
+  }
+
+  /**
+   * Remove all elements
+   */
+  void clear() {
+    std::apply([](deque<Fields>&... col) { (col.clear(), ...); }, columns);
+  }
+};
@@ -0,0 +1,218 @@
+/**
+ * @file
+ * @brief Deque sort header file
+ * @authors Pavlov Ilya
+ *
+ * Contains block-aware parallel sort and stable sort for deque
+ */
+
+#pragma once
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace deque_detail {
+  /**
+   * @brief Uninitialized buffer of sort.
+   *
+   * Remembers constructed ranges, one per task, and destroys them with the buffer.
+   */
+  template <typename T>
+  struct sort_buffer {
+    std::allocator<T> alloc;                       ///< allocator of buffer
+    std::vector<std::pair<size_t, size_t>> built;  ///< constructed ranges
+    T* data = nullptr;                             ///< memory for elements
+    size_t n = 0;                                  ///< number of elements
+
+    /**
+     * Allocate buffer
+     * @param[in] n number of elements
+     * @param[in] tasks max number of tasks constructing elements
+     */
+    sort_buffer(size_t n, size_t tasks) : built(tasks, std::pair<size_t, size_t>(0, 0)), n(n) {
+      data = alloc.allocate(n);
+    }
+
+    sort_buffer(sort_buffer const&) = delete;
+    sort_buffer& operator=(sort_buffer const&) = delete;
+
+    /**
+     * Mark all elements as constructed
+     */
+    void set_built() noexcept {
+      std::fill(built.begin(), built.end(), std::pair<size_t, size_t>(0, 0));
+      built[0] = std::pair<size_t, size_t>(0, n);
+    }
+
+    /**
+     * Just destructor, destroys constructed elements
+     */
+    ~sort_buffer() {
+      for (std::pair<size_t, size_t> const& range : built)
+        std::destroy(data + range.first, data + range.second);
+      alloc.deallocate(data, n);
+    }
+  };
+
+  /**
+   * Merge two sorted ranges into uninitialized memory, taking equal elements from the first range first
+   * @param[in] a the first range
+   * @param[in] a_end end of the first range
+   * @param[in] b the second range
+   * @param[in] b_end end of the second range
+   * @param[in] out memory for result
+   * @param[in] comp comparator
+   * @param[out] built number of constructed elements, valid after exception too
+   */
+  template <typename T, typename Compare>
+  void merge_construct(T* a, T* a_end, T* b, T* b_end, T* out, Compare& comp, size_t& built) {
+    for (; a != a_end && b != b_end; ++out, ++built) {
+      if (comp(*b, *a))
+        std::construct_at(out, std::move(*b++));
+      else
+        std::construct_at(out, std::move(*a++));
+    }
+    for (; a != a_end; ++a, ++out, ++built)
+      std::construct_at(out, std::move(*a));
+    for (; b != b_end; ++b, ++out, ++built)
+      std::construct_at(out, std::move(*b));
+  }
+
+  /**
+   * Sort deque through temporary buffers: runs of whole segments are moved to uninitialized buffer and
+   * sorted in parallel, then sorted runs are merged pairwise and moved back. The second buffer is
+   * constructed by the first merge and assigned to by the next ones, so no element is default
+   * constructed
+   * @param[in] parallel false to run in the calling thread
+   * @param[in] stable true to keep order of equal elements
+   * @param[in] d deque to sort
+   * @param[in] comp comparator
+   */
+  template <typename T, typename Allocator, typename Compare>
+  void sort(bool parallel, bool stable, deque<T, Allocator>& d, Compare comp) {
+    size_t n = d.size();
+    if (n < 2)
+      return;
+
+    auto sort_run = [stable, &comp](T* first, T* last) {
+      if (stable)
+        std::stable_sort(first, last, comp);
+      else
+        std::sort(first, last, comp);
+    };
+
+    size_t max_chunks = parallel ? thread_pool::instance().size() * PARALLEL_CHUNKS_PER_THREAD : 1;
+    sort_buffer<T> src_buf(n, max_chunks);
+    sort_buffer<T> dst_buf(n, max_chunks);
+    sort_buffer<T>* src = &src_buf;
+    sort_buffer<T>* dst = &dst_buf;
+    std::vector<size_t> run_begin(max_chunks + 1, n);
+
+    // every task moves its segments next to each other and sorts them while they are in cache
+    size_t runs = for_each_chunk(parallel, d, [&](size_t chunk, T* first, size_t count, size_t pos) {
+      if (pos < run_begin[chunk]) {
+        run_begin[chunk] = pos;
+        src->built[chunk] = std::pair<size_t, size_t>(pos, pos);
+      }
+      std::uninitialized_move(first, first + count, src->data + pos);
+      src->built[chunk].second = pos + count;
+    });
+    src->set_built();
+    run_begin.resize(runs + 1);
+    run_begin[runs] = n;
+    auto sort_task = [&](size_t k) {
+      sort_run(src->data + run_begin[k], src->data + run_begin[k + 1]);
+    };
+    if (runs == 1)
+      sort_task(0);
+    else
+      thread_pool::instance().run(runs, sort_task);
+
+    bool dst_built = false;
+    while (runs > 1) {
+      size_t pairs = (runs + 1) / 2;
+      auto merge_task = [&](size_t k) {
+        size_t left = run_begin[2 * k];
+        size_t mid = run_begin[2 * k + 1];
+        size_t right = 2 * k + 2 <= runs ? run_begin[2 * k + 2] : mid;
+        T* in = src->data;
+        T* out = dst->data;
+        if (dst_built) {
+          if (right == mid)
+            std::move(in + left, in + mid, out + left);
+          else
+            std::merge(std::make_move_iterator(in + left), std::make_move_iterator(in + mid),
+                       std::make_move_iterator(in + mid), std::make_move_iterator(in + right), out + left, comp);
+          return;
+        }
+
+        dst->built[k] = std::pair<size_t, size_t>(left, left);
+        size_t built = 0;
+        try {
+          if (right == mid)
+            merge_construct(in + left, in + mid, in + mid, in + mid, out + left, comp, built);
+          else
+            merge_construct(in + left, in + mid, in + mid, in + right, out + left, comp, built);
+        }
+        catch (...) {
+          dst->built[k].second = left + built;
+          throw;
+        }
+        dst->built[k].second = left + built;
+      };
+      if (pairs == 1)
+        merge_task(0);
+      else
+        thread_pool::instance().run(pairs, merge_task);
+      if (!dst_built) {
+        dst->set_built();
+        dst_built = true;
+      }
+
+      for (size_t k = 0; k < pairs; ++k)
+        run_begin[k] = run_begin[2 * k];
+      run_begin[pairs] = n;
+      run_begin.resize(pairs + 1);
+      runs = pairs;
+      std::swap(src, dst);
+    }
+
+    for_each_chunk(parallel, d, [src](size_t, T* first, size_t count, size_t pos) {
+      std::move(src->data + pos, src->data + pos + count, first);
+    });
+  }
+}
+
+/**
+ * Sort deque elements
+ * @param[in] policy execution policy
+ * @param[in] d deque to sort
+ * @param[in] comp comparator
+ * @warning if comparator or move throws, deque keeps its size but values of elements are lost: they are
+ * left moved-from, unlike std::sort which leaves a permutation of the original values
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator, typename Compare = std::less<T>,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_sort(ExecutionPolicy&&, deque<T, Allocator>& d, Compare comp = Compare()) {
+  deque_detail::sort(!deque_detail::is_sequenced_v<ExecutionPolicy>, false, d, comp);
+}
+
+/**
+ * Sort deque elements keeping order of equal elements
+ * @param[in] policy execution policy
+ * @param[in] d deque to sort
+ * @param[in] comp comparator
+ * @warning if comparator or move throws, deque keeps its size but values of elements are lost: they are
+ * left moved-from, unlike std::sort which leaves a permutation of the original values
+ */
+template <typename ExecutionPolicy, typename T, typename Allocator, typename Compare = std::less<T>,
+          deque_detail::enable_if_policy_t<ExecutionPolicy> = 0>
+void deque_stable_sort(ExecutionPolicy&&, deque<T, Allocator>& d, Compare comp = Compare()) {
+  deque_detail::sort(!deque_detail::is_sequenced_v<ExecutionPolicy>, true, d, comp);
+}
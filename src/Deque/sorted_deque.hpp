@@ -0,0 +1,425 @@
+/**
+ * @file
+ * @brief Sorted deque header file
+ * @authors Pavlov Ilya
+ *
+ * Contains sorted deque with block-indexed binary search
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <algorithm>
+#include <functional>
+
+/**
+ * @brief Sorted deque class.
+ *
+ * Elements are kept sorted in contiguous fixed-size arrays (blocks) of BlockSize elements. All blocks
+ * except the first and the last are full, so element position gives its block in O(1). First
+ * elements of blocks are copied to a compact index; lookup binary-searches the index and then one
+ * block, touching O(log n) cache lines in two contiguous arrays. Elements arriving in order are
+ * appended in O(1), late ones are inserted into their block and push one element into each following
+ * block, which is cheap when they are late by a few blocks.
+ * @tparam T elements type, copyable
+ * @tparam Compare strict weak order of elements
+ * @tparam BlockSize number of elements in block, power of two
+ * @tparam Allocator allocator type
+ */
+template <typename T, typename Compare = std::less<T>, size_t BlockSize = 256, typename Allocator = std::allocator<T>>
+class sorted_deque {
+  static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0, "block size must be power of two");
+
+private:
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+  static constexpr size_t INDEX_COMPACT_MIN = 64;  ///< min number of dead index entries before compaction
+
+  /**
+   * Contiguous fixed-size array
+   */
+  struct block {
+    T* items = nullptr;  ///< memory for elements
+    size_t begin = 0;    ///< index of the first element in items
+    size_t count = 0;    ///< number of elements
+  };
+
+  deque<block> blocks;    ///< blocks in order of elements
+  std::vector<T> index;   ///< first elements of blocks, starting at index_head
+  size_t index_head = 0;  ///< index entry of the first block
+  size_t _size = 0;       ///< number of elements
+  Compare comp;           ///< order of elements
+  Allocator alloc;        ///< allocator for blocks
+
+  /**
+   * Append empty block
+   * @param[in] first the first element of block, copied to index
+   */
+  void _append_block(T const& first) {
+    block b;
+    b.items = alloc_traits::allocate(alloc, BlockSize);
+    try {
+      index.push_back(first);
+      try {
+        blocks.push_back(b);
+      }
+      catch (...) {
+        index.pop_back();
+        throw;
+      }
+    }
+    catch (...) {
+      alloc_traits::deallocate(alloc, b.items, BlockSize);
+      throw;
+    }
+  }
+
+  /**
+   * Destroy elements of block and deallocate it
+   * @param[in] b block
+   */
+  void _free_block(block& b) noexcept {
+    for (size_t j = 0; j < b.count; ++j)
+      alloc_traits::destroy(alloc, b.items + b.begin + j);
+    alloc_traits::deallocate(alloc, b.items, BlockSize);
+  }
+
+  /**
+   * Get block and index in block of element position
+   * @param[in] pos element position
+   * @return block number and index in block
+   */
+  std::pair<size_t, size_t> _locate(size_t pos) const noexcept {
+    size_t first_count = blocks[0].count;
+    if (pos < first_count)
+      return { 0, pos };
+    pos -= first_count;
+    return { 1 + pos / BlockSize, pos % BlockSize };
+  }
+
+  /**
+   * Get position of element in block
+   * @param[in] k block number
+   * @param[in] j index in block
+   * @return element position
+   */
+  size_t _position(size_t k, size_t j) const noexcept {
+    return k == 0 ? j : blocks[0].count + (k - 1) * BlockSize + j;
+  }
+
+  /**
+   * Search index and then one block
+   * @param[in] value value to search
+   * @param[in] upper false for the first element not less than value, true for the first greater one
+   * @return element position
+   */
+  size_t _search(T const& value, bool upper) const {
+    typename std::vector<T>::const_iterator lo = index.begin() + index_head;
+    size_t m;
+    if (upper)
+      m = std::upper_bound(lo, index.end(), value, comp) - lo;
+    else
+      m = std::lower_bound(lo, index.end(), value, comp) - lo;
+    if (m == 0)
+      return 0;
+
+    block const& b = blocks[m - 1];
+    T const* first = b.items + b.begin;
+    T const* found = upper ? std::upper_bound(first, first + b.count, value, comp)
+                           : std::lower_bound(first, first + b.count, value, comp);
+    return _position(m - 1, found - first);
+  }
+
+  /**
+   * Insert element into block with free slot, shifting towards free side
+   * @param[in] b block
+   * @param[in] j index of new element in block
+   * @param[in] value element to insert
+   */
+  void _block_insert(block& b, size_t j, T&& value) {
+    T* first = b.items + b.begin;
+    if (b.begin + b.count < BlockSize) {
+      if (j == b.count) {
+        alloc_traits::construct(alloc, first + j, std::move(value));
+      }
+      else {
+        alloc_traits::construct(alloc, first + b.count, std::move(first[b.count - 1]));
+        std::move_backward(first + j, first + b.count - 1, first + b.count);
+        first[j] = std::move(value);
+      }
+    }
+    else {
+      if (j == 0) {
+        alloc_traits::construct(alloc, first - 1, std::move(value));
+      }
+      else {
+        alloc_traits::construct(alloc, first - 1, std::move(first[0]));
+        std::move(first + 1, first + j, first);
+        first[j - 1] = std::move(value);
+      }
+      --b.begin;
+    }
+    ++b.count;
+  }
+
+  /**
+   * Insert element, pushing the last element of every full block into the next one
+   * @param[in] k block number
+   * @param[in] j index of new element in block
+   * @param[in] value element to insert
+   */
+  void _insert_at(size_t k, size_t j, T value) {
+    for (;;) {
+      if (k == blocks.size())
+        _append_block(value);
+
+      block& b = blocks[k];
+      if (b.count < BlockSize) {
+        _block_insert(b, j, std::move(value));
+        if (j == 0)
+          index[index_head + k] = b.items[b.begin];
+        return;
+      }
+
+      if (j < BlockSize) {
+        T* first = b.items + b.begin;
+        T carry = std::move(first[BlockSize - 1]);
+        std::move_backward(first + j, first + BlockSize - 1, first + BlockSize);
+        first[j] = std::move(value);
+        if (j == 0)
+          index[index_head + k] = first[0];
+        value = std::move(carry);
+      }
+      ++k;
+      j = 0;
+    }
+  }
+
+  /**
+   * Remove empty first block
+   */
+  void _drop_front_block() noexcept {
+    alloc_traits::deallocate(alloc, blocks[0].items, BlockSize);
+    blocks.pop_front();
+    ++index_head;
+    if (blocks.empty()) {
+      index.clear();
+      index_head = 0;
+    }
+    else if (index_head >= INDEX_COMPACT_MIN && index_head * 2 >= index.size()) {
+      index.erase(index.begin(), index.begin() + index_head);
+      index_head = 0;
+    }
+  }
+
+public:
+  /**
+   * Constructor of empty deque
+   * param[in] comp order of elements
+   * param[in] alloc allocator to use
+   */
+  sorted_deque(Compare const& comp = Compare(), Allocator const& alloc = Allocator()) : comp(comp), alloc(alloc) {}
+
+  sorted_deque(sorted_deque const&) = delete;
+  sorted_deque& operator=(sorted_deque const&) = delete;
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return const reference to element
+   * @warning does not throw out of range exception
+   */
+  T const& operator[](size_t pos) const noexcept {
+    std::pair<size_t, size_t> where = _locate(pos);
+    block const& b = blocks[where.first];
+    return b.items[b.begin + where.second];
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return const reference to element
+   */
+  T const& at(size_t pos) const {
+    if (pos >= _size)
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get the smallest element
+   * @return const reference to the first element
+   */
+  T const& front() const noexcept {
+    return blocks[0].items[blocks[0].begin];
+  }
+
+  /**
+   * Get the greatest element
+   * @return const reference to the last element
+   */
+  T const& back() const noexcept {
+    block const& b = blocks[blocks.size() - 1];
+    return b.items[b.begin + b.count - 1];
+  }
+
+  /**
+   * Check if deque is empty
+   * @return true if deque is empty else false
+   */
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  /**
+   * Get number of elements
+   * @return number of elements
+   */
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  /**
+   * Find the first element not less than value
+   * @param[in] value value to search
+   * @return position of element or size() if there is no such element
+   */
+  size_t lower_bound(T const& value) const {
+    return _search(value, false);
+  }
+
+  /**
+   * Find the first element greater than value
+   * @param[in] value value to search
+   * @return position of element or size() if there is no such element
+   */
+  size_t upper_bound(T const& value) const {
+    return _search(value, true);
+  }
+
+  /**
+   * Insert element after all elements not greater than it
+   * pram[in] value element to add
+   * @return position of new element
+   */
+  size_t insert(T const& value) {
+    if (_size == 0 || !comp(value, back())) {
+      block* last = blocks.empty() ? nullptr : &blocks[blocks.size() - 1];
+      if (last == nullptr || last->begin + last->count == BlockSize)
+        _append_block(value);
+      block& b = blocks[blocks.size() - 1];
+      alloc_traits::construct(alloc, b.items + b.begin + b.count, value);
+      ++b.count;
+      return _size++;
+    }
+
+    size_t pos = _search(value, true);
+    std::pair<size_t, size_t> where = pos == 0 ? std::pair<size_t, size_t>(0, 0) : _locate(pos - 1);
+    if (pos != 0)
+      ++where.second;
+    _insert_at(where.first, where.second, value);
+    ++_size;
+    return pos;
+  }
+
+  /**
+   * Add element, same as insert(), O(1) if it is not less than the last element
+   * pram[in] value element to add
+   */
+  void push_back(T const& value) {
+    insert(value);
+  }
+
+  /**
+   * Remove the smallest element
+   */
+  void pop_front() noexcept {
+    block& b = blocks[0];
+    alloc_traits::destroy(alloc, b.items + b.begin);
+    ++b.begin;
+    --b.count;
+    --_size;
+    if (b.count == 0)
+      _drop_front_block();
+    else
+      index[index_head] = b.items[b.begin];
+  }
+
+  /**
+   * Remove the greatest element
+   */
+  void pop_back() noexcept {
+    block& b = blocks[blocks.size() - 1];
+    alloc_traits::destroy(alloc, b.items + b.begin + b.count - 1);
+    --b.count;
+    --_size;
+    if (b.count == 0) {
+      alloc_traits::deallocate(alloc, b.items, BlockSize);
+      blocks.pop_back();
+      index.pop_back();
+      if (blocks.empty()) {
+        index.clear();
+        index_head = 0;
+      }
+    }
+  }
+
+  /**
+   * Remove all elements less than value, block by block
+   * @param[in] value the smallest value to keep
+   * @return number of removed elements
+   */
+  size_t erase_before(T const& value) {
+    size_t n = _search(value, false);
+    size_t left = n;
+    while (left > 0) {
+      block& b = blocks[0];
+      size_t count = b.count < left ? b.count : left;
+      for (size_t j = 0; j < count; ++j)
+        alloc_traits::destroy(alloc, b.items + b.begin + j);
+      b.begin += count;
+      b.count -= count;
+      left -= count;
+      if (b.count == 0)
+        _drop_front_block();
+      else
+        index[index_head] = b.items[b.begin];
+    }
+    _size -= n;
+    return n;
+  }
+
+  /**
+   * Call function for every element in order, block by block
+   * @param[in] f function taking const reference to element
+   */
+  template <typename Function>
+  void for_each(Function f) const {
+    for (size_t k = 0; k < blocks.size(); ++k) {
+      block const& b = blocks[k];
+      for (size_t j = 0; j < b.count; ++j)
+        f(b.items[b.begin + j]);
+    }
+  }
+
+  /**
+   * Remove all elements
+   */
+  void clear() noexcept {
+    for (size_t k = 0; k < blocks.size(); ++k)
+      _free_block(blocks[k]);
+    blocks.clear();
+    index.clear();
+    index_head = 0;
+    _size = 0;
+  }
+
+  /**
+   * Just destructor
+   */
+  ~sorted_deque() {
+    clear();
+  }
+};
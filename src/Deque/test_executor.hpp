@@ -0,0 +1,165 @@
+/**
+ * @file
+ * @brief Test executor header file
+ * @authors Pavlov Ilya
+ *
+ * Contains single-threaded executor and task type for running coroutines in tests
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <vector>
+
+/**
+ * @brief Coroutine started by single_thread_executor.
+ */
+class task {
+public:
+  /**
+   * Promise of task coroutine
+   */
+  struct promise_type {
+    std::exception_ptr error;  ///< exception thrown by coroutine
+    bool finished = false;     ///< coroutine has reached its end
+
+    task get_return_object() noexcept {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() const noexcept {
+      return {};
+    }
+
+    std::suspend_always final_suspend() noexcept {
+      finished = true;
+      return {};
+    }
+
+    void return_void() const noexcept {}
+
+    void unhandled_exception() noexcept {
+      error = std::current_exception();
+    }
+  };
+
+private:
+  friend class single_thread_executor;
+
+  std::coroutine_handle<promise_type> handle;  ///< owned coroutine
+
+  /**
+   * Constructor from coroutine handle
+   * @param[in] handle coroutine handle
+   */
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+
+public:
+  task(task&& other) noexcept : handle(other.handle) {
+    other.handle = nullptr;
+  }
+
+  task(task const&) = delete;
+  task& operator=(task const&) = delete;
+
+  /**
+   * Just destructor
+   */
+  ~task() {
+    if (handle)
+      handle.destroy();
+  }
+};
+
+/**
+ * @brief Executor running coroutines one by one in the calling thread.
+ *
+ * Coroutines still suspended when executor is destroyed are destroyed with it.
+ */
+class single_thread_executor {
+private:
+  deque<std::coroutine_handle<>> ready;                          ///< coroutines ready to run
+  std::vector<std::coroutine_handle<task::promise_type>> tasks;  ///< owned coroutines
+
+  /**
+   * Awaitable result of schedule()
+   */
+  struct schedule_awaiter {
+    single_thread_executor& executor;  ///< executor to reschedule on
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      executor.ready.push_back(handle);
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+public:
+  single_thread_executor() = default;
+  single_thread_executor(single_thread_executor const&) = delete;
+  single_thread_executor& operator=(single_thread_executor const&) = delete;
+
+  /**
+   * Take task and schedule its start
+   * @param[in] t task to start
+   */
+  void spawn(task t) {
+    tasks.push_back(t.handle);
+    ready.push_back(t.handle);
+    t.handle = nullptr;
+  }
+
+  /**
+   * Suspend calling coroutine and put it to the end of ready queue
+   * @return awaitable
+   */
+  schedule_awaiter schedule() noexcept {
+    return schedule_awaiter{ *this };
+  }
+
+  /**
+   * Run ready coroutines until none left
+   * @warning rethrows exception escaped from task
+   */
+  void run() {
+    while (!ready.empty()) {
+      std::coroutine_handle<> handle = ready.front();
+      ready.pop_front();
+      handle.resume();
+
+      for (std::coroutine_handle<task::promise_type> t : tasks) {
+        if (t.promise().error) {
+          std::exception_ptr error = t.promise().error;
+          t.promise().error = nullptr;
+          std::rethrow_exception(error);
+        }
+      }
+    }
+  }
+
+  /**
+   * Get number of spawned tasks that have not finished yet
+   * @return number of unfinished tasks
+   */
+  size_t pending() const noexcept {
+    size_t count = 0;
+    for (std::coroutine_handle<task::promise_type> t : tasks)
+      count += !t.promise().finished;
+    return count;
+  }
+
+  /**
+   * Just destructor
+   */
+  ~single_thread_executor() {
+    for (std::coroutine_handle<task::promise_type> t : tasks)
+      t.destroy();
+  }
+};
@@ -0,0 +1,188 @@
+/**
+ * @file
+ * @brief Thread pool header file
+ * @authors Pavlov Ilya
+ *
+ * Contains thread pool used by parallel deque algorithms
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size thread pool running batches of indexed tasks.
+ *
+ * Caller of run() takes part in the batch, so pool of n threads keeps n - 1 workers.
+ */
+class thread_pool {
+private:
+  /**
+   * Batch of tasks run by one run() call
+   */
+  struct batch {
+    std::function<void(size_t)> job;  ///< task body taking task number
+    size_t tasks = 0;                 ///< number of tasks
+    std::atomic<size_t> next{ 0 };    ///< number of the next task to take
+    std::atomic<size_t> done{ 0 };    ///< number of finished tasks
+    std::exception_ptr error;         ///< the first exception thrown by tasks
+    std::mutex error_mutex;           ///< guard for error
+  };
+
+  std::vector<std::thread> workers;  ///< worker threads
+  std::mutex mutex;                  ///< guard for current and generation
+  std::condition_variable wake;      ///< signals new batch or stop to workers
+  std::condition_variable finished;  ///< signals end of batch to run()
+  std::shared_ptr<batch> current;    ///< batch being run
+  size_t generation = 0;             ///< number of started batches
+  bool stop = false;                 ///< workers should exit
+  std::mutex run_mutex;              ///< serializes run() calls
+
+  /**
+   * Check if calling thread runs pool task
+   * @return reference to thread flag
+   */
+  static bool& _inside_task() noexcept {
+    thread_local bool inside = false;
+    return inside;
+  }
+
+  /**
+   * Take and run tasks of batch until none left
+   * @param[in] b batch to work on
+   */
+  void _work(batch& b) {
+    bool& inside = _inside_task();
+    bool was_inside = inside;
+    inside = true;
+    for (;;) {
+      size_t k = b.next.fetch_add(1);
+      if (k >= b.tasks)
+        break;
+
+      try {
+        b.job(k);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(b.error_mutex);
+        if (!b.error)
+          b.error = std::current_exception();
+      }
+
+      if (b.done.fetch_add(1) + 1 == b.tasks) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+      }
+    }
+    inside = was_inside;
+  }
+
+  /**
+   * Worker thread body
+   */
+  void _worker() {
+    size_t seen = 0;
+    for (;;) {
+      std::shared_ptr<batch> b;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stop || generation != seen; });
+        if (stop)
+          return;
+        seen = generation;
+        b = current;
+      }
+      if (b)
+        _work(*b);
+    }
+  }
+
+public:
+  /**
+   * Constructor
+   * @param[in] threads number of threads including the calling one
+   */
+  explicit thread_pool(size_t threads = std::thread::hardware_concurrency()) {
+    for (size_t k = 1; k < threads; ++k)
+      workers.emplace_back([this] { _worker(); });
+  }
+
+  thread_pool(thread_pool const&) = delete;
+  thread_pool& operator=(thread_pool const&) = delete;
+
+  /**
+   * Get pool shared by parallel deque algorithms
+   * @return reference to pool with a thread per hardware core
+   */
+  static thread_pool& instance() {
+    static thread_pool pool;
+    return pool;
+  }
+
+  /**
+   * Get number of threads
+   * @return number of threads including the calling one
+   */
+  size_t size() const noexcept {
+    return workers.size() + 1;
+  }
+
+  /**
+   * Run tasks and wait for them to finish
+   * @param[in] tasks number of tasks
+   * @param[in] job task body taking task number
+   * @warning rethrows the first exception thrown by tasks after all of them finished
+   */
+  void run(size_t tasks, std::function<void(size_t)> job) {
+    if (tasks == 0)
+      return;
+
+    // nested batches and pools without workers run in the calling thread
+    if (workers.empty() || tasks == 1 || _inside_task()) {
+      for (size_t k = 0; k < tasks; ++k)
+        job(k);
+      return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+    std::shared_ptr<batch> b = std::make_shared<batch>();
+    b->job = std::move(job);
+    b->tasks = tasks;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      current = b;
+      ++generation;
+    }
+    wake.notify_all();
+
+    _work(*b);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      finished.wait(lock, [&] { return b->done.load() == b->tasks; });
+      current.reset();
+    }
+
+    if (b->error)
+      std::rethrow_exception(b->error);
+  }
+
+  /**
+   * Just destructor
+   */
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+      worker.join();
+  }
+};
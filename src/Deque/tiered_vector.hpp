@@ -0,0 +1,720 @@
+/**
+ * @file
+ * @brief Tiered vector header file
+ * @authors Pavlov Ilya
+ *
+ * Contains deque-like container of circular fixed-size arrays with O(sqrt n) insertion and erasure
+ */
+
+#pragma once
+
+#include "deque.hpp"
+
+#include <bit>
+#include <iterator>
+
+/**
+ * @brief Tiered vector class.
+ *
+ * Elements are kept in circular fixed-size arrays (blocks) of B elements. All blocks except
+ * the first and the last are full, so element position gives its block in O(1). Inserting or erasing
+ * in the middle shifts elements inside one block and moves one element between each pair of
+ * neighbour blocks on the way to the nearer end, which is O(B + n / B). B is a power of two kept
+ * around sqrt(n).
+ * @tparam T elements type
+ * @tparam Allocator allocator type
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class tiered_vector {
+private:
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+  static constexpr size_t MIN_BLOCK_SIZE = 16;  ///< min number of elements in block
+
+  /**
+   * Circular fixed-size array
+   */
+  struct block {
+    T* slots = nullptr;  ///< memory for elements
+    size_t head = 0;     ///< index of the first element in slots
+    size_t count = 0;    ///< number of elements
+  };
+
+  deque<block> blocks;               ///< blocks in order of elements
+  size_t _size = 0;                  ///< number of elements
+  size_t block_size = MIN_BLOCK_SIZE;  ///< number of slots in block, power of two
+  Allocator alloc;                   ///< allocator for slots
+
+  /**
+   * Get element of block
+   * @param[in] b block
+   * @param[in] j index of element in block
+   * @return reference to element
+   */
+  T& _at(block const& b, size_t j) const noexcept {
+    return b.slots[(b.head + j) & (block_size - 1)];
+  }
+
+  /**
+   * Allocate empty block
+   * @return block
+   */
+  block _new_block() {
+    block b;
+    b.slots = alloc_traits::allocate(alloc, block_size);
+    return b;
+  }
+
+  /**
+   * Destroy elements of block and deallocate it
+   * @param[in] b block
+   */
+  void _free_block(block& b) noexcept {
+    for (size_t j = 0; j < b.count; ++j)
+      alloc_traits::destroy(alloc, &_at(b, j));
+    alloc_traits::deallocate(alloc, b.slots, block_size);
+  }
+
+  /**
+   * Construct element at the end of block
+   * @param[in] b block with free slot
+   * @param[in] args constructor parameters
+   */
+  template <typename... Args>
+  void _block_push_back(block& b, Args&&... args) {
+    alloc_traits::construct(alloc, &_at(b, b.count), std::forward<Args>(args)...);
+    ++b.count;
+  }
+
+  /**
+   * Construct element at the front of block
+   * @param[in] b block with free slot
+   * @param[in] args constructor parameters
+   */
+  template <typename... Args>
+  void _block_push_front(block& b, Args&&... args) {
+    size_t head = (b.head - 1) & (block_size - 1);
+    alloc_traits::construct(alloc, b.slots + head, std::forward<Args>(args)...);
+    b.head = head;
+    ++b.count;
+  }
+
+  /**
+   * Destroy the last element of block
+   * @param[in] b not empty block
+   */
+  void _block_pop_back(block& b) noexcept {
+    alloc_traits::destroy(alloc, &_at(b, b.count - 1));
+    --b.count;
+  }
+
+  /**
+   * Destroy the first element of block
+   * @param[in] b not empty block
+   */
+  void _block_pop_front(block& b) noexcept {
+    alloc_traits::destroy(alloc, b.slots + b.head);
+    b.head = (b.head + 1) & (block_size - 1);
+    --b.count;
+  }
+
+  /**
+   * Insert element into block with free slot, shifting the shorter side
+   * @param[in] b block
+   * @param[in] j index of new element in block
+   * @param[in] value element to insert
+   */
+  void _block_insert(block& b, size_t j, T&& value) {
+    if (j == b.count) {
+      _block_push_back(b, std::move(value));
+    }
+    else if (j == 0) {
+      _block_push_front(b, std::move(value));
+    }
+    else if (j < b.count / 2) {
+      _block_push_front(b, std::move(_at(b, 0)));
+      for (size_t t = 1; t < j; ++t)
+        _at(b, t) = std::move(_at(b, t + 1));
+      _at(b, j) = std::move(value);
+    }
+    else {
+      _block_push_back(b, std::move(_at(b, b.count - 1)));
+      for (size_t t = b.count - 2; t > j; --t)
+        _at(b, t) = std::move(_at(b, t - 1));
+      _at(b, j) = std::move(value);
+    }
+  }
+
+  /**
+   * Erase element of block, shifting the shorter side
+   * @param[in] b block
+   * @param[in] j index of element in block
+   */
+  void _block_erase(block& b, size_t j) {
+    if (j < b.count / 2) {
+      for (size_t t = j; t > 0; --t)
+        _at(b, t) = std::move(_at(b, t - 1));
+      _block_pop_front(b);
+    }
+    else {
+      for (size_t t = j; t + 1 < b.count; ++t)
+        _at(b, t) = std::move(_at(b, t + 1));
+      _block_pop_back(b);
+    }
+  }
+
+  /**
+   * Find block and index in block of position
+   * @param[in] pos number of position
+   * @return block number and index in it
+   */
+  std::pair<size_t, size_t> _locate(size_t pos) const noexcept {
+    size_t first = blocks[0].count;
+    if (pos < first)
+      return std::pair<size_t, size_t>(0, pos);
+    pos -= first;
+    size_t shift = std::countr_zero(block_size);
+    return std::pair<size_t, size_t>(1 + (pos >> shift), pos & (block_size - 1));
+  }
+
+  /**
+   * Construct element in the end without changing block size
+   * @param[in] args constructor parameters
+   */
+  template <typename... Args>
+  void _append(Args&&... args) {
+    if (blocks.empty() || blocks.back().count == block_size)
+      blocks.push_back(_new_block());
+
+    try {
+      _block_push_back(blocks.back(), std::forward<Args>(args)...);
+    }
+    catch (...) {
+      if (blocks.back().count == 0) {
+        alloc_traits::deallocate(alloc, blocks.back().slots, block_size);
+        blocks.pop_back();
+      }
+      throw;
+    }
+    ++_size;
+  }
+
+  /**
+   * Move elements to blocks of other size
+   * @param[in] new_block_size new number of slots in block
+   */
+  void _rebuild(size_t new_block_size) {
+    tiered_vector tmp(alloc);
+    tmp.block_size = new_block_size;
+    for (size_t k = 0; k < blocks.size(); ++k) {
+      for (size_t j = 0; j < blocks[k].count; ++j)
+        tmp._append(std::move(_at(blocks[k], j)));
+    }
+    _swap(tmp);
+  }
+
+  /**
+   * Keep block size around square root of number of elements
+   */
+  void _adapt() {
+    if (_size > 4 * block_size * block_size)
+      _rebuild(block_size * 2);
+    else if (block_size > MIN_BLOCK_SIZE && _size < block_size * block_size / 16)
+      _rebuild(block_size / 2);
+  }
+
+  /**
+   * Exchange contents with other tiered vector
+   * @param[in] other tiered vector to swap with
+   */
+  void _swap(tiered_vector& other) noexcept {
+    std::swap(blocks, other.blocks);
+    std::swap(_size, other._size);
+    std::swap(block_size, other.block_size);
+    std::swap(alloc, other.alloc);
+  }
+
+  /**
+   * @brief tiered vector iterator class
+   */
+  template <bool IsConst>
+  class common_iterator {
+    friend class tiered_vector;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, T const*, T*>;
+    using reference = std::conditional_t<IsConst, T const&, T&>;
+
+  private:
+    tiered_vector const* owner = nullptr;  ///< iterated container
+    size_t pos = 0;                        ///< number of position
+
+    /**
+     * Constructor from container and position
+     * @param[in] owner iterated container
+     * @param[in] pos number of position
+     */
+    common_iterator(tiered_vector const* owner, size_t pos) noexcept : owner(owner), pos(pos) {}
+
+  public:
+    common_iterator() = default;
+
+    reference operator*() const noexcept {
+      return (*owner)[pos];
+    }
+
+    pointer operator->() const noexcept {
+      return &(*owner)[pos];
+    }
+
+    reference operator[](difference_type n) const noexcept {
+      return (*owner)[pos + n];
+    }
+
+    common_iterator& operator++() noexcept {
+      ++pos;
+      return *this;
+    }
+
+    common_iterator operator++(int) noexcept {
+      common_iterator tmp = *this;
+      ++pos;
+      return tmp;
+    }
+
+    common_iterator& operator--() noexcept {
+      --pos;
+      return *this;
+    }
+
+    common_iterator operator--(int) noexcept {
+      common_iterator tmp = *this;
+      --pos;
+      return tmp;
+    }
+
+    common_iterator& operator+=(difference_type n) noexcept {
+      pos += n;
+      return *this;
+    }
+
+    common_iterator& operator-=(difference_type n) noexcept {
+      pos -= n;
+      return *this;
+    }
+
+    common_iterator operator+(difference_type n) const noexcept {
+      return common_iterator(owner, pos + n);
+    }
+
+    friend common_iterator operator+(difference_type n, common_iterator const& it) noexcept {
+      return it + n;
+    }
+
+    common_iterator operator-(difference_type n) const noexcept {
+      return common_iterator(owner, pos - n);
+    }
+
+    difference_type operator-(common_iterator const& other) const noexcept {
+      return (difference_type)pos - (difference_type)other.pos;
+    }
+
+    bool operator==(common_iterator const& other) const noexcept {
+      return pos == other.pos;
+    }
+
+    bool operator!=(common_iterator const& other) const noexcept {
+      return pos != other.pos;
+    }
+
+    bool operator<(common_iterator const& other) const noexcept {
+      return pos < other.pos;
+    }
+
+    bool operator<=(common_iterator const& other) const noexcept {
+      return pos <= other.pos;
+    }
+
+    bool operator>(common_iterator const& other) const noexcept {
+      return pos > other.pos;
+    }
+
+    bool operator>=(common_iterator const& other) const noexcept {
+      return pos >= other.pos;
+    }
+  };
+
+public:
+  using iterator = common_iterator<false>;
+  using const_iterator = common_iterator<true>;
+
+  /*
+   * Begin of tiered vector
+   * @return iterator pointed to the first element
+   */
+  iterator begin() const noexcept {
+    return iterator(this, 0);
+  }
+
+  /*
+   * End of tiered vector
+   * @return iterator pointed to the next after last element
+   */
+  iterator end() const noexcept {
+    return iterator(this, _size);
+  }
+
+  /*
+   * Begin of tiered vector
+   * @return const iterator pointed to the first element
+   */
+  const_iterator cbegin() const noexcept {
+    return const_iterator(this, 0);
+  }
+
+  /*
+   * End of tiered vector
+   * @return const iterator pointed to the next after last element
+   */
+  const_iterator cend() const noexcept {
+    return const_iterator(this, _size);
+  }
+
+  /**
+   * Constructor of empty tiered vector
+   * param[in] alloc allocator to use
+   */
+  tiered_vector(Allocator const& alloc = Allocator()) : alloc(alloc) {}
+
+  /**
+   * Copy constructor
+   * param[in] other tiered vector to copy
+   */
+  tiered_vector(tiered_vector const& other)
+      : alloc(alloc_traits::select_on_container_copy_construction(other.alloc)) {
+    block_size = other.block_size;
+    for (size_t k = 0; k < other.size(); ++k)
+      _append(other[k]);
+  }
+
+  /**
+   * Move constructor
+   * param[in] other tiered vector to move
+   */
+  tiered_vector(tiered_vector&& other) noexcept : alloc(other.alloc) {
+    _swap(other);
+  }
+
+  /**
+   * Copy assignment operator
+   * param[in] other tiered vector to copy
+   * @return reference to this tiered vector
+   */
+  tiered_vector& operator=(tiered_vector const& other) {
+    if (this == &other)
+      return *this;
+
+    tiered_vector tmp(other);
+    _swap(tmp);
+    return *this;
+  }
+
+  /**
+   * Move assignment operator
+   * param[in] other tiered vector to move
+   * @return reference to this tiered vector
+   */
+  tiered_vector& operator=(tiered_vector&& other) noexcept {
+    if (this == &other)
+      return *this;
+
+    clear();
+    _swap(other);
+    return *this;
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return reference to element at this position
+   * @warning does not throw out of range exception
+   */
+  T& operator[](size_t pos) const noexcept {
+    std::pair<size_t, size_t> where = _locate(pos);
+    return _at(blocks[where.first], where.second);
+  }
+
+  /**
+   * Get element by number of position
+   * param[in] pos number of position
+   * @return reference to element at this position
+   */
+  T& at(size_t pos) const {
+    if (pos >= _size)
+      throw std::out_of_range("index out of range");
+
+    return (*this)[pos];
+  }
+
+  /**
+   * Get the first element
+   * @return reference to the first element
+   */
+  T& front() const noexcept {
+    return _at(blocks[0], 0);
+  }
+
+  /**
+   * Get last element
+   * @return reference to the last element
+   */
+  T& back() const noexcept {
+    block const& b = blocks.back();
+    return _at(b, b.count - 1);
+  }
+
+  /**
+   * Check if tiered vector is empty
+   * @return true if tiered vector is empty else false
+   */
+  bool empty() const noexcept {
+    return _size == 0;
+  }
+
+  /**
+   * Get number of elements
+   * @return number of elements
+   */
+  size_t size() const noexcept {
+    return _size;
+  }
+
+  /**
+   * Get number of slots in block
+   * @return block size
+   */
+  size_t block_capacity() const noexcept {
+    return block_size;
+  }
+
+  /**
+   * Construct element in the end
+   * pram[in] args constructor parameters
+   */
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    _append(std::forward<Args>(args)...);
+    _adapt();
+  }
+
+  /**
+   * Construct element in the front
+   * pram[in] args constructor parameters
+   */
+  template <typename... Args>
+  void emplace_front(Args&&... args) {
+    if (blocks.empty() || blocks[0].count == block_size)
+      blocks.push_front(_new_block());
+
+    try {
+      _block_push_front(blocks[0], std::forward<Args>(args)...);
+    }
+    catch (...) {
+      if (blocks[0].count == 0) {
+        alloc_traits::deallocate(alloc, blocks[0].slots, block_size);
+        blocks.pop_front();
+      }
+      throw;
+    }
+    ++_size;
+    _adapt();
+  }
+
+  /**
+   * Add element to the end
+   * pram[in] value element to add
+   */
+  void push_back(T const& value) {
+    emplace_back(value);
+  }
+
+  /**
+   * Add element to the end
+   * pram[in] value element to add
+   */
+  void push_back(T&& value) {
+    emplace_back(std::move(value));
+  }
+
+  /**
+   * Add element to the front
+   * pram[in] value element to add
+   */
+  void push_front(T const& value) {
+    emplace_front(value);
+  }
+
+  /**
+   * Add element to the front
+   * pram[in] value element to add
+   */
+  void push_front(T&& value) {
+    emplace_front(std::move(value));
+  }
+
+  /**
+   * Remove element from the back
+   */
+  void pop_back() {
+    _block_pop_back(blocks.back());
+    if (blocks.back().count == 0) {
+      alloc_traits::deallocate(alloc, blocks.back().slots, block_size);
+      blocks.pop_back();
+    }
+    --_size;
+    _adapt();
+  }
+
+  /**
+   * Remove element from the front
+   */
+  void pop_front() {
+    _block_pop_front(blocks[0]);
+    if (blocks[0].count == 0) {
+      alloc_traits::deallocate(alloc, blocks[0].slots, block_size);
+      blocks.pop_front();
+    }
+    --_size;
+    _adapt();
+  }
+
+  /**
+   * Insert element before position
+   * param[in] pos number of position, not greater than size
+   * param[in] value element to insert
+   */
+  void insert(size_t pos, T value) {
+    if (pos > _size)
+      throw std::out_of_range("index out of range");
+    if (pos == _size) {
+      push_back(std::move(value));
+      return;
+    }
+    if (pos == 0) {
+      push_front(std::move(value));
+      return;
+    }
+
+    std::pair<size_t, size_t> where = _locate(pos);
+    size_t k = where.first;
+    size_t j = where.second;
+    if (blocks[k].count < block_size) {
+      _block_insert(blocks[k], j, std::move(value));
+    }
+    else if (k < blocks.size() / 2) {
+      if (j == 0) {
+        // insert after the last element of previous block instead
+        --k;
+        j = blocks[k].count;
+      }
+      if (blocks[k].count < block_size) {
+        _block_insert(blocks[k], j, std::move(value));
+      }
+      else {
+        // make room in block k by moving one element of every block before it to the front
+        if (blocks[0].count == block_size) {
+          blocks.push_front(_new_block());
+          ++k;
+        }
+        for (size_t b = 0; b < k; ++b) {
+          _block_push_back(blocks[b], std::move(_at(blocks[b + 1], 0)));
+          _block_pop_front(blocks[b + 1]);
+        }
+        _block_insert(blocks[k], j - 1, std::move(value));
+      }
+    }
+    else {
+      // make room in block k by moving one element of every block after it to the back
+      if (blocks.back().count == block_size)
+        blocks.push_back(_new_block());
+      for (size_t b = blocks.size() - 1; b > k; --b) {
+        _block_push_front(blocks[b], std::move(_at(blocks[b - 1], blocks[b - 1].count - 1)));
+        _block_pop_back(blocks[b - 1]);
+      }
+      _block_insert(blocks[k], j, std::move(value));
+    }
+    ++_size;
+    _adapt();
+  }
+
+  /**
+   * Erase element
+   * param[in] pos number of position
+   */
+  void erase(size_t pos) {
+    if (pos >= _size)
+      throw std::out_of_range("index out of range");
+
+    std::pair<size_t, size_t> where = _locate(pos);
+    size_t k = where.first;
+    _block_erase(blocks[k], where.second);
+    if (k < blocks.size() / 2) {
+      // fill block k from the blocks before it
+      for (size_t b = k; b > 0; --b) {
+        _block_push_front(blocks[b], std::move(_at(blocks[b - 1], blocks[b - 1].count - 1)));
+        _block_pop_back(blocks[b - 1]);
+      }
+      if (blocks[0].count == 0) {
+        alloc_traits::deallocate(alloc, blocks[0].slots, block_size);
+        blocks.pop_front();
+      }
+    }
+    else {
+      // fill block k from the blocks after it
+      for (size_t b = k; b + 1 < blocks.size(); ++b) {
+        _block_push_back(blocks[b], std::move(_at(blocks[b + 1], 0)));
+        _block_pop_front(blocks[b + 1]);
+      }
+      if (blocks.back().count == 0) {
+        alloc_traits::deallocate(alloc, blocks.back().slots, block_size);
+        blocks.pop_back();
+      }
+    }
+    --_size;
+    _adapt();
+  }
+
+  /**
+   * Remove all elements
+   */
+  void clear() noexcept {
+    for (size_t k = 0; k < blocks.size(); ++k)
+      _free_block(blocks[k]);
+    blocks.clear();
+    _size = 0;
+    block_size = MIN_BLOCK_SIZE;
+  }
+
+  /**
+   * Friend operator<< to print elements
+   * @param[in] out output stream
+   * @param[in] vector tiered vector to output
+   * @return reference to stream
+   */
+  friend std::ostream& operator<<(std::ostream& out, tiered_vector const& vector) {
+    for (auto& el : vector) {
+      out << el << " ";
+    }
+    return out;
+  }
+
+  /**
+   * Just destructor
+   */
+  ~tiered_vector() {
+    clear();
+  }
+};
@@ -1,5 +1,35 @@
 #include "gtest/gtest.h"
 #include "../src/Deque/deque.hpp"
+#include "../src/Deque/async_channel.hpp"
+#include "../src/Deque/block_pool.hpp"
+#include "../src/Deque/compressed_deque.hpp"
+#include "../src/Deque/concurrent_deque.hpp"
+#include "../src/Deque/cow_deque.hpp"
+#include "../src/Deque/minmax_heap.hpp"
+#include "../src/Deque/parallel.hpp"
+#include "../src/Deque/record_deque.hpp"
+#ifdef __linux__
+#include "../src/Deque/shm_deque.hpp"
+#include <sys/wait.h>
+#endif
+#include "../src/Deque/sliding_window.hpp"
+#include "../src/Deque/soa_deque.hpp"
+#include "../src/Deque/sort.hpp"
+#include "../src/Deque/sorted_deque.hpp"
+#include "../src/Deque/test_executor.hpp"
+#include "../src/Deque/tiered_vector.hpp"
+#ifdef DEQUE_HAS_SCATTER_GATHER_IO
+#include "../src/Deque/mapped_deque.hpp"
+#include <sys/wait.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <deque>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <vector>
 
 TEST(DequeConstructorTest, ConstructorWithoutParams) {
   deque<int> deque;
@@ -252,6 +282,1769 @@ TEST(DequePopFrontTest, BecomesEmpty) {
   EXPECT_TRUE(deque.empty());
 }
 
+TEST(DequeSaveLoadTest, StreamRoundTrip) {
+  deque<int> deque1;
+  for (int i = 0; i < 10; ++i)
+    deque1.push_back(i);
+  deque1.push_front(-1);
+  std::stringstream stream;
+  deque1.save(stream);
+  deque<int> deque2(3, 7);
+  deque2.load(stream);
+  EXPECT_EQ(deque2.size(), deque1.size());
+  for (size_t i = 0; i < deque1.size(); ++i)
+    EXPECT_EQ(deque2[i], deque1[i]);
+}
+
+TEST(DequeSaveLoadTest, EmptyDeque) {
+  deque<int> deque1;
+  std::stringstream stream;
+  deque1.save(stream);
+  deque<int> deque2(5, 1);
+  deque2.load(stream);
+  EXPECT_TRUE(deque2.empty());
+  deque2.push_back(1);
+  EXPECT_EQ(deque2.back(), 1);
+}
+
+TEST(DequeSaveLoadTest, WrongElementSize) {
+  deque<int> deque1(5, 1);
+  std::stringstream stream;
+  deque1.save(stream);
+  deque<long long> deque2;
+  EXPECT_THROW(deque2.load(stream), std::runtime_error);
+}
+
+TEST(DequeSaveLoadTest, TruncatedImage) {
+  deque<int> deque1(5, 1);
+  std::stringstream stream;
+  deque1.save(stream);
+  std::string image = stream.str();
+  std::stringstream truncated(image.substr(0, image.size() - 1));
+  deque<int> deque2(2, 3);
+  EXPECT_THROW(deque2.load(truncated), std::runtime_error);
+  EXPECT_EQ(deque2.size(), 2);
+}
+
+#ifdef DEQUE_HAS_SCATTER_GATHER_IO
+TEST(DequeSaveLoadTest, FileDescriptorRoundTrip) {
+  deque<double> deque1;
+  for (int i = 0; i < 1000; ++i)
+    deque1.push_back(i * 0.5);
+  for (int i = 0; i < 3; ++i)
+    deque1.pop_front();
+  FILE* file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  int fd = fileno(file);
+  deque1.save(fd);
+  ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0);
+  deque<double> deque2;
+  deque2.load(fd);
+  std::fclose(file);
+  EXPECT_EQ(deque2.size(), deque1.size());
+  for (size_t i = 0; i < deque1.size(); ++i)
+    EXPECT_EQ(deque2[i], deque1[i]);
+}
+#endif
+
+#ifdef DEQUE_HAS_SCATTER_GATHER_IO
+TEST(MappedDequeTest, PushPopAcrossBlocks) {
+  std::string path = testing::TempDir() + "mapped_deque_push_pop.bin";
+  std::remove(path.c_str());
+  {
+    mapped_deque<int, 65536> deque(path);
+    int count = 50000;
+    for (int i = 0; i < count; ++i)
+      deque.push_back(i);
+    deque.push_front(-1);
+    EXPECT_EQ(deque.size(), count + 1);
+    EXPECT_EQ(deque.front(), -1);
+    EXPECT_EQ(deque.back(), count - 1);
+    EXPECT_EQ(deque[20000], 19999);
+    for (int i = 0; i < 30000; ++i)
+      deque.pop_front();
+    deque.pop_back();
+    EXPECT_EQ(deque.front(), 29999);
+    EXPECT_EQ(deque.back(), count - 2);
+    EXPECT_THROW(deque.at(deque.size()), std::out_of_range);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(MappedDequeTest, ReopenRecoversContent) {
+  std::string path = testing::TempDir() + "mapped_deque_reopen.bin";
+  std::remove(path.c_str());
+  {
+    mapped_deque<long long, 65536> deque(path);
+    for (long long i = 0; i < 40000; ++i)
+      deque.push_back(i);
+    for (int i = 0; i < 20000; ++i)
+      deque.pop_front();
+    deque.push_front(7);
+    deque.sync();
+  }
+  {
+    mapped_deque<long long, 65536> deque(path);
+    ASSERT_EQ(deque.size(), 20001);
+    EXPECT_EQ(deque.front(), 7);
+    EXPECT_EQ(deque[1], 20000);
+    EXPECT_EQ(deque.back(), 39999);
+    deque.push_back(40000);
+    EXPECT_EQ(deque.back(), 40000);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(MappedDequeTest, RecoversAfterProcessCrash) {
+  std::string path = testing::TempDir() + "mapped_deque_crash.bin";
+  std::remove(path.c_str());
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    // the deque is never closed: the file keeps exactly what the process has written
+    auto* deque = new mapped_deque<int, 65536>(path);
+    for (int i = 0; i < 40000; ++i)
+      deque->push_front(-i);
+    for (int i = 0; i < 20000; ++i)
+      deque->push_back(i);
+    for (int i = 0; i < 16383; ++i)
+      deque->pop_front();
+    deque->pop_back();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+  {
+    mapped_deque<int, 65536> deque(path);
+    ASSERT_EQ(deque.size(), 40000 + 20000 - 16383 - 1);
+    EXPECT_EQ(deque.front(), -(40000 - 16383 - 1));
+    EXPECT_EQ(deque.back(), 19998);
+    deque.push_front(1);
+    deque.pop_front();
+    deque.pop_front();
+    EXPECT_EQ(deque.front(), -(40000 - 16383 - 2));
+  }
+  std::remove(path.c_str());
+}
+
+TEST(MappedDequeTest, LayoutMismatch) {
+  std::string path = testing::TempDir() + "mapped_deque_mismatch.bin";
+  std::remove(path.c_str());
+  {
+    mapped_deque<int, 65536> deque(path);
+    deque.push_back(1);
+  }
+  using wide_deque = mapped_deque<long long, 65536>;
+  EXPECT_THROW(wide_deque deque(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+#endif
+
+TEST(SlidingWindowTest, SlidingMaxMatchesRescan) {
+  std::vector<int> values;
+  for (int i = 0; i < 500; ++i)
+    values.push_back((i * 7919) % 101 - 50);
+  size_t width = 17;
+  sliding_window<int, max_op<int>> window;
+  for (size_t i = 0; i < values.size(); ++i) {
+    window.push(values[i]);
+    if (window.size() > width)
+      window.evict();
+    size_t from = i + 1 > width ? i + 1 - width : 0;
+    int expected = values[from];
+    for (size_t k = from; k <= i; ++k)
+      expected = std::max(expected, values[k]);
+    EXPECT_EQ(window.query(), expected);
+  }
+}
+
+TEST(SlidingWindowTest, SlidingMin) {
+  sliding_window<int, min_op<int>> window;
+  int values[] = { 5, 3, 8, 1, 9, 2 };
+  window.push_range(values, values + 6);
+  EXPECT_EQ(window.query(), 1);
+  window.evict();
+  window.evict();
+  window.evict();
+  window.evict();
+  EXPECT_EQ(window.query(), 2);
+  EXPECT_EQ(window.front(), 9);
+}
+
+TEST(SlidingWindowTest, SumAggregate) {
+  sliding_window<long long, std::plus<long long>> window;
+  for (long long i = 1; i <= 100; ++i)
+    window.push(i);
+  for (int i = 0; i < 50; ++i)
+    window.evict();
+  EXPECT_EQ(window.query(), 3775);
+  window.push(1000);
+  EXPECT_EQ(window.query(), 4775);
+}
+
+TEST(SlidingWindowTest, EmptyWindow) {
+  sliding_window<int, max_op<int>> window;
+  EXPECT_TRUE(window.empty());
+  EXPECT_THROW(window.query(), std::out_of_range);
+  EXPECT_THROW(window.evict(), std::out_of_range);
+}
+
+TEST(DequeSegmentTest, SegmentsCoverDeque) {
+  deque<int> deque;
+  for (int i = 0; i < 30; ++i)
+    deque.push_back(i);
+  deque.push_front(-1);
+  deque.push_front(-2);
+  size_t total = 0;
+  for (size_t k = 0; k < deque.segment_count(); ++k) {
+    std::pair<int*, size_t> seg = deque.segment(k);
+    EXPECT_EQ(deque.segment_start(k), total);
+    for (size_t j = 0; j < seg.second; ++j)
+      EXPECT_EQ(seg.first[j], deque[total + j]);
+    total += seg.second;
+  }
+  EXPECT_EQ(total, deque.size());
+}
+
+TEST(DequeParallelTest, ForEachAndReduce) {
+  deque<long long> deque;
+  int count = 40000;
+  for (int i = 0; i < count; ++i)
+    deque.push_back(i);
+  deque.push_front(-1);
+  deque_for_each(deque_execution::par, deque, [](long long& value) { value *= 2; });
+  EXPECT_EQ(deque[0], -2);
+  EXPECT_EQ(deque[count], 2LL * (count - 1));
+  long long sum = deque_reduce(deque_execution::par, deque, 0LL, std::plus<long long>());
+  EXPECT_EQ(sum, (long long)count * (count - 1) - 2);
+  EXPECT_EQ(deque_reduce(deque_execution::seq, deque, 5LL, std::plus<long long>()), sum + 5);
+}
+
+TEST(DequeParallelTest, TransformCopyFill) {
+  int count = 40000;
+  deque<int> src;
+  for (int i = 0; i < count; ++i)
+    src.push_back(i);
+  src.pop_front();
+  deque<long long> dst(src.size(), 0);
+  deque_transform(deque_execution::par, src, dst, [](int value) { return value * 3LL; });
+  for (size_t i = 0; i < src.size(); i += 997)
+    EXPECT_EQ(dst[i], src[i] * 3LL);
+  EXPECT_EQ(dst.back(), (count - 1) * 3LL);
+
+  deque<int> copy(src.size() + 2, 0);
+  deque_copy(deque_execution::par_unseq, src, copy);
+  EXPECT_EQ(copy[0], 1);
+  EXPECT_EQ(copy[src.size() - 1], count - 1);
+  EXPECT_EQ(copy.back(), 0);
+
+  deque_fill(deque_execution::par, copy, 7);
+  EXPECT_EQ(deque_reduce(deque_execution::par, copy, 0LL, std::plus<long long>()), 7LL * copy.size());
+
+  deque<long long> small(1, 0);
+  EXPECT_THROW(deque_transform(deque_execution::par, src, small, [](int value) { return value; }), std::out_of_range);
+}
+
+TEST(DequeParallelTest, CloneFillTeardown) {
+  deque<std::string> src;
+  for (int i = 0; i < 50000; ++i)
+    src.push_back(std::to_string(i));
+  src.pop_front_n(3);
+  src.push_front("x");
+  src.set_realtime_growth(true);
+
+  deque<std::string> copy = deque_clone(deque_execution::par, src);
+  EXPECT_TRUE(copy == src);
+  EXPECT_TRUE(copy.realtime_growth());
+  EXPECT_EQ(copy.front_seq(), src.front_seq());
+  copy.push_front("y");
+  copy.push_back("z");
+  EXPECT_EQ(copy.front(), "y");
+  EXPECT_EQ(copy[1], "x");
+
+  deque<std::string> seq_copy = deque_clone(deque_execution::seq, src);
+  EXPECT_TRUE(seq_copy == src);
+
+  deque<int> filled = deque_filled(deque_execution::par, 100001, 7);
+  EXPECT_EQ(filled.size(), 100001);
+  EXPECT_EQ(deque_reduce(deque_execution::par, filled, 0LL, std::plus<long long>()), 700007LL);
+  size_t capacity = filled.max_size();
+  EXPECT_EQ(capacity, deque<int>(100001, 7).max_size());
+  filled.push_front(1);
+  EXPECT_EQ(filled.front(), 1);
+  EXPECT_EQ(filled.max_size(), capacity);
+  EXPECT_TRUE(deque_filled(deque_execution::par, 0, 7).empty());
+
+  uint64_t end_seq = copy.back_seq() + 1;
+  deque_teardown(deque_execution::par, copy);
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(copy.realtime_growth());
+  EXPECT_EQ(copy.front_seq(), end_seq);
+  EXPECT_EQ(copy.max_size(), 0);
+  copy.push_back("again");
+  copy.push_front("first");
+  EXPECT_EQ(copy.back(), "again");
+  EXPECT_EQ(copy.front(), "first");
+  EXPECT_EQ(copy.front_seq(), end_seq - 1);
+  for (int i = 0; i < 1000; ++i)
+    copy.push_front(std::to_string(i));
+  EXPECT_EQ(copy.size(), 1002);
+  EXPECT_EQ(copy.front(), "999");
+  deque_teardown(deque_execution::seq, filled);
+  EXPECT_TRUE(filled.empty());
+  EXPECT_EQ(filled.max_size(), 0);
+  filled.push_front(3);
+  filled.push_back(4);
+  EXPECT_EQ(filled.front(), 3);
+  EXPECT_EQ(filled.back(), 4);
+}
+
+TEST(DequeParallelTest, CloneIsExceptionSafe) {
+  struct counted {
+    static std::atomic<int>& live() {
+      static std::atomic<int> value{ 0 };
+      return value;
+    }
+    static std::atomic<int>& budget() {
+      static std::atomic<int> value{ INT_MAX };
+      return value;
+    }
+    int value;
+    counted(int value) : value(value) {
+      ++live();
+    }
+    counted(counted const& other) : value(other.value) {
+      if (budget().fetch_sub(1) <= 0)
+        throw std::runtime_error("copy failed");
+      ++live();
+    }
+    ~counted() {
+      --live();
+    }
+  };
+
+  {
+    deque<counted> src;
+    for (int i = 0; i < 40000; ++i)
+      src.emplace_back(i);
+    counted::budget() = 25000;
+    EXPECT_THROW(deque_clone(deque_execution::par, src), std::runtime_error);
+    EXPECT_EQ(counted::live(), 40000);
+    counted::budget() = INT_MAX;
+    deque<counted> copy = deque_clone(deque_execution::par, src);
+    EXPECT_EQ(counted::live(), 80000);
+    EXPECT_EQ(copy[39999].value, 39999);
+  }
+  EXPECT_EQ(counted::live(), 0);
+}
+
+TEST(ThreadPoolTest, RunsEveryTaskOnce) {
+  thread_pool pool(4);
+  std::vector<std::atomic<int>> hits(1000);
+  pool.run(hits.size(), [&hits](size_t k) { ++hits[k]; });
+  for (std::atomic<int>& hit : hits)
+    EXPECT_EQ(hit.load(), 1);
+}
+
+TEST(ThreadPoolTest, RethrowsTaskException) {
+  thread_pool pool(3);
+  std::atomic<int> done{ 0 };
+  EXPECT_THROW(pool.run(100, [&done](size_t k) {
+    if (k == 42)
+      throw std::runtime_error("task failed");
+    ++done;
+  }), std::runtime_error);
+  EXPECT_EQ(done.load(), 99);
+}
+
+TEST(DequeSortTest, SortMatchesStdSort) {
+  deque<int> deque;
+  std::vector<int> expected;
+  unsigned state = 12345;
+  for (int i = 0; i < 50000; ++i) {
+    state = state * 1103515245u + 12345u;
+    int value = (int)(state >> 8) % 100000;
+    deque.push_back(value);
+    expected.push_back(value);
+  }
+  deque.push_front(-5);
+  expected.push_back(-5);
+  std::sort(expected.begin(), expected.end());
+  deque_sort(deque_execution::par, deque);
+  ASSERT_EQ(deque.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+    ASSERT_EQ(deque[i], expected[i]);
+}
+
+TEST(DequeSortTest, StableSortKeepsOrderOfEqualElements) {
+  deque<std::pair<int, int>> deque;
+  for (int i = 0; i < 40000; ++i)
+    deque.push_back(std::make_pair((i * 37) % 11, i));
+  auto by_key = [](std::pair<int, int> const& a, std::pair<int, int> const& b) { return a.first < b.first; };
+  deque_stable_sort(deque_execution::par, deque, by_key);
+  for (size_t i = 1; i < deque.size(); ++i) {
+    ASSERT_LE(deque[i - 1].first, deque[i].first);
+    if (deque[i - 1].first == deque[i].first) {
+      ASSERT_LT(deque[i - 1].second, deque[i].second);
+    }
+  }
+}
+
+TEST(DequeSortTest, SequencedDescending) {
+  deque<std::string> deque;
+  deque.push_back("b");
+  deque.push_back("d");
+  deque.push_front("a");
+  deque.push_back("c");
+  deque_sort(deque_execution::seq, deque, std::greater<std::string>());
+  EXPECT_EQ(deque[0], "d");
+  EXPECT_EQ(deque[1], "c");
+  EXPECT_EQ(deque[2], "b");
+  EXPECT_EQ(deque[3], "a");
+}
+
+TEST(DequeSortTest, ElementsWithoutDefaultConstructor) {
+  struct item {
+    explicit item(int key) : key(key) {}
+    int key;
+  };
+  deque<item> deque;
+  for (int i = 0; i < 100; ++i)
+    deque.push_back(item((i * 13) % 100));
+  deque_sort(deque_execution::par, deque, [](item const& a, item const& b) { return a.key < b.key; });
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(deque[i].key, i);
+}
+
+TEST(DequeSortTest, ThrowingComparatorDoesNotLeak) {
+  struct counted {
+    static std::atomic<int>& live() {
+      static std::atomic<int> count{ 0 };
+      return count;
+    }
+    explicit counted(int key) : key(std::to_string(key)) { ++live(); }
+    counted(counted const& other) : key(other.key) { ++live(); }
+    counted(counted&& other) noexcept : key(std::move(other.key)) { ++live(); }
+    counted& operator=(counted const&) = default;
+    counted& operator=(counted&&) noexcept = default;
+    ~counted() { --live(); }
+    std::string key;
+  };
+  int n = 40000;
+  auto make = [n] {
+    deque<counted> d;
+    for (int i = 0; i < n; ++i)
+      d.push_back(counted((i * 7919) % n));
+    return d;
+  };
+
+  std::atomic<size_t> calls{ 0 };
+  size_t limit = SIZE_MAX;
+  auto comp = [&](counted const& a, counted const& b) {
+    if (calls.fetch_add(1, std::memory_order_relaxed) == limit)
+      throw std::runtime_error("comparator failed");
+    return a.key < b.key;
+  };
+  {
+    deque<counted> d = make();
+    deque_stable_sort(deque_execution::par, d, comp);
+    EXPECT_EQ(counted::live().load(), n);
+  }
+  size_t total = calls.load();
+
+  // throw at every stage: sorting runs, merging into uninitialized buffer, merging into built one
+  for (size_t k = 1; k < 24; ++k) {
+    deque<counted> d = make();
+    calls = 0;
+    limit = total * k / 24;
+    EXPECT_THROW(deque_stable_sort(deque_execution::par, d, comp), std::runtime_error);
+    EXPECT_EQ(counted::live().load(), n);
+    EXPECT_EQ(d.size(), n);
+  }
+  EXPECT_EQ(counted::live().load(), 0);
+}
+
+TEST(AsyncChannelTest, UnboundedPushThenPop) {
+  single_thread_executor executor;
+  async_channel<int> channel;
+  std::vector<int> received;
+  executor.spawn([](async_channel<int>& channel) -> task {
+    for (int i = 0; i < 10; ++i)
+      co_await channel.push(i);
+  }(channel));
+  executor.spawn([](async_channel<int>& channel, std::vector<int>& received) -> task {
+    for (int i = 0; i < 10; ++i)
+      received.push_back(co_await channel.pop());
+  }(channel, received));
+  executor.run();
+  EXPECT_EQ(executor.pending(), 0);
+  ASSERT_EQ(received.size(), 10);
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(received[i], i);
+}
+
+TEST(AsyncChannelTest, DirectHandOffToWaitingConsumer) {
+  single_thread_executor executor;
+  async_channel<std::string> channel;
+  std::string received;
+  executor.spawn([](async_channel<std::string>& channel, std::string& received) -> task {
+    received = co_await channel.pop();
+  }(channel, received));
+  executor.run();
+  EXPECT_EQ(executor.pending(), 1);
+  EXPECT_TRUE(channel.try_push("hello"));
+  EXPECT_EQ(received, "hello");
+  EXPECT_EQ(channel.size(), 0);
+  EXPECT_EQ(executor.pending(), 0);
+}
+
+TEST(AsyncChannelTest, BoundedProducerWaitsForSpace) {
+  single_thread_executor executor;
+  async_channel<int> channel(2);
+  int pushed = 0;
+  executor.spawn([](async_channel<int>& channel, int& pushed) -> task {
+    for (int i = 0; i < 5; ++i) {
+      co_await channel.push(i);
+      ++pushed;
+    }
+  }(channel, pushed));
+  executor.run();
+  EXPECT_EQ(pushed, 2);
+  EXPECT_EQ(channel.size(), 2);
+  EXPECT_FALSE(channel.try_push(100));
+  EXPECT_EQ(channel.try_pop(), 0);
+  EXPECT_EQ(pushed, 3);
+  EXPECT_EQ(channel.try_pop(), 1);
+  EXPECT_EQ(channel.try_pop(), 2);
+  EXPECT_EQ(channel.try_pop(), 3);
+  EXPECT_EQ(channel.try_pop(), 4);
+  EXPECT_EQ(pushed, 5);
+  EXPECT_FALSE(channel.try_pop().has_value());
+}
+
+TEST(AsyncChannelTest, RendezvousChannel) {
+  single_thread_executor executor;
+  async_channel<int> channel(0);
+  std::vector<int> received;
+  executor.spawn([](async_channel<int>& channel) -> task {
+    co_await channel.push(1);
+    co_await channel.push(2);
+  }(channel));
+  executor.spawn([](async_channel<int>& channel, std::vector<int>& received, single_thread_executor& executor) -> task {
+    received.push_back(co_await channel.pop());
+    co_await executor.schedule();
+    received.push_back(co_await channel.pop());
+  }(channel, received, executor));
+  executor.run();
+  EXPECT_EQ(executor.pending(), 0);
+  ASSERT_EQ(received.size(), 2);
+  EXPECT_EQ(received[1], 2);
+}
+
+TEST(AsyncChannelTest, PopMany) {
+  single_thread_executor executor;
+  async_channel<int> channel;
+  std::vector<std::vector<int>> batches;
+  for (int i = 0; i < 5; ++i)
+    channel.try_push(i);
+  executor.spawn([](async_channel<int>& channel, std::vector<std::vector<int>>& batches) -> task {
+    batches.push_back(co_await channel.pop_many(3));
+    batches.push_back(co_await channel.pop_many(3));
+    batches.push_back(co_await channel.pop_many(3));
+  }(channel, batches));
+  executor.run();
+  ASSERT_EQ(batches.size(), 2);
+  EXPECT_EQ(batches[0].size(), 3);
+  EXPECT_EQ(batches[1].size(), 2);
+  channel.try_push(42);
+  ASSERT_EQ(batches.size(), 3);
+  EXPECT_EQ(batches[2].size(), 1);
+  EXPECT_EQ(batches[2][0], 42);
+}
+
+TEST(DequePopFrontNTest, RemovesElementsAcrossBlocks) {
+  deque<std::string> deque;
+  for (int i = 0; i < 100; ++i)
+    deque.push_back(std::to_string(i));
+  deque.pop_front_n(37);
+  EXPECT_EQ(deque.size(), 63);
+  EXPECT_EQ(deque.front(), "37");
+  EXPECT_EQ(deque.back(), "99");
+  deque.push_front("x");
+  deque.push_back("y");
+  EXPECT_EQ(deque[1], "37");
+  deque.pop_front_n(deque.size());
+  EXPECT_TRUE(deque.empty());
+  deque.push_back("z");
+  EXPECT_EQ(deque.front(), "z");
+  EXPECT_THROW(deque.pop_front_n(2), std::out_of_range);
+}
+
+TEST(DequePopBackNTest, RemovesElementsAcrossBlocks) {
+  deque<int> deque;
+  for (int i = 0; i < 100; ++i)
+    deque.push_back(i);
+  deque.pop_back_n(61);
+  EXPECT_EQ(deque.size(), 39);
+  EXPECT_EQ(deque.back(), 38);
+  deque.push_back(500);
+  EXPECT_EQ(deque[39], 500);
+  deque.pop_back_n(40);
+  EXPECT_TRUE(deque.empty());
+  deque.push_front(1);
+  EXPECT_EQ(deque.back(), 1);
+}
+
+TEST(DequePopFrontWhileTest, StopsAtFirstMismatch) {
+  deque<int> deque;
+  for (int i = 0; i < 50; ++i)
+    deque.push_back(i);
+  size_t removed = deque.pop_front_while([](int value) { return value < 23; });
+  EXPECT_EQ(removed, 23);
+  EXPECT_EQ(deque.front(), 23);
+  EXPECT_EQ(deque.pop_front_while([](int) { return true; }), 27);
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(DequeDrainFrontTest, MovesElementsOut) {
+  deque<std::string> deque;
+  for (int i = 0; i < 20; ++i)
+    deque.push_back(std::string(30, 'a' + i));
+  std::vector<std::string> out;
+  deque.drain_front(13, std::back_inserter(out));
+  ASSERT_EQ(out.size(), 13);
+  EXPECT_EQ(out[12], std::string(30, 'a' + 12));
+  EXPECT_EQ(deque.size(), 7);
+  EXPECT_EQ(deque.front(), std::string(30, 'a' + 13));
+  deque.drain_front(100, std::back_inserter(out));
+  EXPECT_EQ(out.size(), 20);
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(CowDequeTest, CopySharesBlocks) {
+  cow_deque<std::string, 8> deque1;
+  for (int i = 0; i < 100; ++i)
+    deque1.push_back(std::to_string(i));
+  cow_deque<std::string, 8> snapshot = deque1;
+  EXPECT_EQ(snapshot.size(), 100);
+  EXPECT_EQ(deque1.shared_blocks(), 13);
+  EXPECT_EQ(&snapshot[50], &deque1[50]);
+}
+
+TEST(CowDequeTest, WriteCopiesOnlyTouchedBlock) {
+  cow_deque<std::string, 8> deque1;
+  for (int i = 0; i < 100; ++i)
+    deque1.push_back(std::to_string(i));
+  cow_deque<std::string, 8> snapshot = deque1;
+  deque1.modify(50) = "changed";
+  EXPECT_EQ(deque1[50], "changed");
+  EXPECT_EQ(snapshot[50], "50");
+  EXPECT_EQ(deque1.shared_blocks(), 12);
+  EXPECT_EQ(&snapshot[10], &deque1[10]);
+  deque1.push_back("last");
+  deque1.push_front("first");
+  EXPECT_EQ(snapshot.size(), 100);
+  EXPECT_EQ(snapshot.back(), "99");
+  EXPECT_EQ(snapshot.front(), "0");
+  EXPECT_EQ(deque1.back(), "last");
+  EXPECT_EQ(deque1.front(), "first");
+  EXPECT_EQ(deque1.size(), 102);
+}
+
+TEST(CowDequeTest, PopsDoNotAffectSnapshot) {
+  cow_deque<std::string, 8> deque1;
+  for (int i = 0; i < 20; ++i)
+    deque1.push_back(std::to_string(i));
+  cow_deque<std::string, 8> snapshot = deque1;
+  for (int i = 0; i < 11; ++i)
+    deque1.pop_front();
+  deque1.pop_back();
+  deque1.push_back("x");
+  deque1.push_front("y");
+  EXPECT_EQ(deque1.front(), "y");
+  EXPECT_EQ(deque1[1], "11");
+  EXPECT_EQ(deque1.back(), "x");
+  for (int i = 0; i < 20; ++i)
+    EXPECT_EQ(snapshot[i], std::to_string(i));
+  snapshot.clear();
+  EXPECT_TRUE(snapshot.empty());
+  EXPECT_EQ(deque1.size(), 10);
+  EXPECT_EQ(deque1.shared_blocks(), 0);
+}
+
+TEST(CowDequeTest, PushFrontAndPopToEmpty) {
+  cow_deque<int, 4> deque;
+  for (int i = 0; i < 10; ++i)
+    deque.push_front(i);
+  EXPECT_EQ(deque.front(), 9);
+  EXPECT_EQ(deque.back(), 0);
+  for (int i = 0; i < 10; ++i)
+    deque.pop_back();
+  EXPECT_TRUE(deque.empty());
+  deque.push_back(3);
+  EXPECT_EQ(deque.at(0), 3);
+  EXPECT_THROW(deque.at(1), std::out_of_range);
+}
+
+TEST(SoaDequeTest, ProxyReferences) {
+  soa_deque<long long, double, int> deque;
+  for (int i = 0; i < 30; ++i)
+    deque.push_back(i * 10LL, i * 0.5, i);
+  deque.push_front(std::make_tuple(-10LL, -0.5, -1));
+  EXPECT_EQ(deque.size(), 31);
+  EXPECT_EQ(std::get<0>(deque.front()), -10);
+  auto [timestamp, price, qty] = deque[5];
+  EXPECT_EQ(timestamp, 40);
+  EXPECT_EQ(price, 2.0);
+  qty = 100;
+  EXPECT_EQ(std::get<2>(deque[5]), 100);
+  deque[6] = std::make_tuple(1LL, 2.0, 3);
+  EXPECT_EQ(std::get<1>(deque.at(6)), 2.0);
+  EXPECT_THROW(deque.at(31), std::out_of_range);
+  deque.pop_front();
+  deque.pop_back();
+  EXPECT_EQ(std::get<2>(deque.back()), 28);
+}
+
+TEST(SoaDequeTest, ColumnSegments) {
+  soa_deque<int, char> deque;
+  for (int i = 0; i < 50; ++i)
+    deque.push_back(i, 'a');
+  deque.pop_front();
+  long long sum = 0;
+  size_t count = 0;
+  for (std::pair<int*, size_t> seg : deque.segments<0>()) {
+    for (size_t j = 0; j < seg.second; ++j)
+      sum += seg.first[j];
+    count += seg.second;
+  }
+  EXPECT_EQ(count, 49);
+  EXPECT_EQ(sum, 49 * 50 / 2);
+  EXPECT_EQ(deque.column<1>().size(), 49);
+}
+
+TEST(CompressedDequeTest, PushPopAccess) {
+  compressed_deque<uint64_t, 16> deque;
+  for (uint64_t i = 0; i < 200; ++i)
+    deque.push_back(1000 + i * 3);
+  EXPECT_EQ(deque.size(), 200);
+  EXPECT_EQ(deque.front(), 1000);
+  EXPECT_EQ(deque.back(), 1000 + 199 * 3);
+  for (uint64_t i = 0; i < 200; ++i)
+    EXPECT_EQ(deque[i], 1000 + i * 3);
+  EXPECT_THROW(deque.at(200), std::out_of_range);
+
+  for (int i = 0; i < 37; ++i)
+    deque.pop_front();
+  for (int i = 0; i < 21; ++i)
+    deque.pop_back();
+  EXPECT_EQ(deque.size(), 142);
+  EXPECT_EQ(deque.front(), 1000 + 37 * 3);
+  EXPECT_EQ(deque.back(), 1000 + 178 * 3);
+  for (uint64_t i = 0; i < 142; ++i)
+    EXPECT_EQ(deque[i], 1000 + (i + 37) * 3);
+
+  while (!deque.empty())
+    deque.pop_back();
+  deque.push_back(5);
+  EXPECT_EQ(deque.front(), 5);
+}
+
+TEST(CompressedDequeTest, ArbitraryValuesAndForEach) {
+  compressed_deque<uint64_t, 8> deque;
+  std::vector<uint64_t> expected;
+  uint64_t x = 88172645463325252ull;
+  for (int i = 0; i < 100; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    deque.push_back(x);
+    expected.push_back(x);
+  }
+  std::vector<uint64_t> got;
+  deque.for_each([&](uint64_t v) { got.push_back(v); });
+  EXPECT_EQ(got, expected);
+  EXPECT_EQ(deque[50], expected[50]);
+}
+
+TEST(CompressedDequeTest, BothEndsMatchDeque) {
+  compressed_deque<uint64_t, 16> wide;
+  compressed_deque<uint8_t, 8> narrow;
+  std::deque<uint64_t> expected;
+  uint64_t x = 88172645463325252ull;
+  for (int step = 0; step < 20000; ++step) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    // values from steady to random to exercise every width
+    uint64_t value = step % 3000 < 1500 ? (uint64_t)step * 3 : x >> (x % 64);
+    unsigned op = (x >> 20) % 6;
+    if (op < 2 || expected.empty()) {
+      wide.push_back(value);
+      narrow.push_back((uint8_t)value);
+      expected.push_back(value);
+    }
+    else if (op < 4) {
+      wide.push_front(value);
+      narrow.push_front((uint8_t)value);
+      expected.push_front(value);
+    }
+    else if (op == 4) {
+      wide.pop_front();
+      narrow.pop_front();
+      expected.pop_front();
+    }
+    else {
+      wide.pop_back();
+      narrow.pop_back();
+      expected.pop_back();
+    }
+    ASSERT_EQ(wide.size(), expected.size());
+    if (!expected.empty()) {
+      ASSERT_EQ(wide.front(), expected.front());
+      ASSERT_EQ(wide.back(), expected.back());
+      ASSERT_EQ(narrow.back(), (uint8_t)expected.back());
+    }
+  }
+  std::vector<uint64_t> got;
+  wide.for_each([&](uint64_t v) { got.push_back(v); });
+  EXPECT_TRUE(std::equal(got.begin(), got.end(), expected.begin(), expected.end()));
+  std::vector<uint8_t> got_narrow;
+  narrow.for_each([&](uint8_t v) { got_narrow.push_back(v); });
+  ASSERT_EQ(got_narrow.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(got_narrow[i], (uint8_t)expected[i]);
+    ASSERT_EQ(wide[i], expected[i]);
+  }
+}
+
+TEST(CompressedDequeTest, MemoryUsage) {
+  compressed_deque<> deque;
+  for (uint64_t i = 0; i < 128 * 100; ++i)
+    deque.push_back(1700000000000ull + i * 5 + (i % 3));
+  EXPECT_LT(deque.memory_usage() * 4, deque.size() * sizeof(uint64_t));
+  uint64_t sum = 0;
+  deque.for_each([&](uint64_t v) { sum += v - 1700000000000ull; });
+  uint64_t expected = 0;
+  for (uint64_t i = 0; i < 128 * 100; ++i)
+    expected += i * 5 + (i % 3);
+  EXPECT_EQ(sum, expected);
+}
+
+TEST(DequeBoolTest, PushPopAndProxy) {
+  deque<bool> deque;
+  std::vector<bool> expected;
+  for (int i = 0; i < 300; ++i) {
+    deque.push_back(i % 3 == 0);
+    expected.push_back(i % 3 == 0);
+  }
+  for (int i = 0; i < 70; ++i) {
+    deque.push_front(i % 5 == 0);
+    expected.insert(expected.begin(), i % 5 == 0);
+  }
+  ASSERT_EQ(deque.size(), expected.size());
+  for (size_t k = 0; k < expected.size(); ++k)
+    EXPECT_EQ(deque[k], expected[k]);
+
+  deque[7] = true;
+  deque[8].flip();
+  expected[7] = true;
+  expected[8] = !expected[8];
+  EXPECT_EQ(deque[7], true);
+  EXPECT_EQ(deque[8], expected[8]);
+  EXPECT_THROW(deque.at(370), std::out_of_range);
+
+  for (int i = 0; i < 65; ++i) {
+    deque.pop_front();
+    expected.erase(expected.begin());
+  }
+  for (int i = 0; i < 100; ++i) {
+    deque.pop_back();
+    expected.pop_back();
+  }
+  EXPECT_TRUE(std::equal(deque.cbegin(), deque.cend(), expected.begin(), expected.end()));
+  EXPECT_EQ(deque.front(), expected.front());
+  EXPECT_EQ(deque.back(), expected.back());
+}
+
+TEST(DequeBoolTest, CountAndFind) {
+  deque<bool> deque(200, false);
+  EXPECT_EQ(deque.count(), 0);
+  EXPECT_EQ(deque.find_first(), 200);
+  deque.push_front(false);
+  deque[3] = true;
+  deque[64] = true;
+  deque[150] = true;
+  deque[200] = true;
+  EXPECT_EQ(deque.count(), 4);
+  EXPECT_EQ(deque.find_first(), 3);
+  EXPECT_EQ(deque.find_next(3), 64);
+  EXPECT_EQ(deque.find_next(64), 150);
+  EXPECT_EQ(deque.find_next(150), 200);
+  EXPECT_EQ(deque.find_next(200), 201);
+  EXPECT_EQ(std::count(deque.begin(), deque.end(), true), 4);
+
+  deque.pop_back();
+  EXPECT_EQ(deque.count(), 3);
+  EXPECT_EQ(deque.find_next(150), 200);
+  auto it = deque.begin() + 10;
+  *it = true;
+  EXPECT_EQ(deque.find_next(3), 10);
+  EXPECT_EQ(::deque<bool>(128, true).count(), 128);
+}
+
+TEST(BlockPoolTest, ReusesBlocksOnSameThread) {
+  using pooled_deque = deque<int, pool_allocator<int>>;
+  {
+    pooled_deque warm;
+    for (int i = 0; i < 100; ++i)
+      warm.push_back(i);
+  }
+  block_pool_stats before = block_pool::instance().stats();
+  {
+    pooled_deque deque;
+    for (int i = 0; i < 100; ++i)
+      deque.push_back(i);
+    for (int i = 0; i < 100; ++i)
+      EXPECT_EQ(deque[i], i);
+    pooled_deque copy = deque;
+    EXPECT_EQ(copy.back(), 99);
+  }
+  block_pool_stats after = block_pool::instance().stats();
+  EXPECT_GT(after.magazine_hits, before.magazine_hits);
+  EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+}
+
+TEST(BlockPoolTest, DepotAndWatermark) {
+  block_pool& pool = block_pool::instance();
+  std::vector<void*> blocks;
+  std::thread producer([&] {
+    for (int i = 0; i < 100; ++i)
+      blocks.push_back(pool.allocate(1000));
+    for (void* block : blocks)
+      pool.deallocate(block, 1000);
+  });
+  producer.join();
+
+  block_pool_stats before = pool.stats();
+  EXPECT_GE(before.bytes_cached, 100 * 1024);
+  void* block = pool.allocate(1000);
+  EXPECT_GT(pool.stats().depot_hits, before.depot_hits);
+  pool.deallocate(block, 1000);
+
+  pool.set_watermark(0);
+  pool.trim();
+  block_pool_stats trimmed = pool.stats();
+  EXPECT_EQ(trimmed.bytes_cached, 0);
+  EXPECT_GT(trimmed.os_releases, before.os_releases);
+  pool.set_watermark(64 << 20);
+}
+
+constexpr int constexpr_deque_sum() {
+  deque<int> deque;
+  for (int i = 0; i < 40; ++i)
+    deque.push_back(i);
+  for (int i = 1; i <= 20; ++i)
+    deque.push_front(-i);
+  for (int i = 0; i < 15; ++i)
+    deque.pop_front();
+  for (int i = 0; i < 10; ++i)
+    deque.pop_back();
+
+  ::deque<int> copy = deque;
+  int sum = 0;
+  for (auto it = copy.begin(); it != copy.end(); ++it)
+    sum += *it;
+  return sum + deque[2] * 1000 + (int)deque.size() * 100000;
+}
+
+constexpr bool constexpr_deque_moves() {
+  deque<int> deque(10, 7);
+  ::deque<int> moved = std::move(deque);
+  moved.emplace_front(1);
+  moved.clear();
+  moved.emplace_back(3);
+  return deque.empty() && moved.size() == 1 && moved.front() == 3;
+}
+
+TEST(DequeConstexprTest, ConstantEvaluation) {
+  // -5..-1 and 0..29 remain
+  static_assert(constexpr_deque_sum() == (-15 + 435) + (-3) * 1000 + 35 * 100000);
+  static_assert(constexpr_deque_moves());
+  EXPECT_EQ(constexpr_deque_sum(), (-15 + 435) + (-3) * 1000 + 35 * 100000);
+}
+
+TEST(DequeRealtimeTest, MatchesStdDeque) {
+  deque<int> deque;
+  deque.set_realtime_growth(true);
+  EXPECT_TRUE(deque.realtime_growth());
+  std::vector<int> expected;
+  size_t front = 0;
+  unsigned x = 12345;
+  for (int step = 0; step < 200000; ++step) {
+    x = x * 1103515245 + 12345;
+    unsigned op = (x >> 16) % 10;
+    if (op < 4) {
+      deque.push_back(step);
+      expected.push_back(step);
+    }
+    else if (op < 7 && front > 0) {
+      deque.push_front(step);
+      expected[--front] = step;
+    }
+    else if (op < 9 && expected.size() > front) {
+      deque.pop_front();
+      ++front;
+    }
+    else if (expected.size() > front) {
+      deque.pop_back();
+      expected.pop_back();
+    }
+    ASSERT_EQ(deque.size(), expected.size() - front);
+  }
+  for (size_t k = 0; k < deque.size(); ++k)
+    ASSERT_EQ(deque[k], expected[front + k]);
+}
+
+TEST(DequeRealtimeTest, GrowsBothWaysAndKeepsMode) {
+  deque<int> deque;
+  deque.set_realtime_growth(true);
+  for (int i = 0; i < 50000; ++i) {
+    deque.push_back(i);
+    deque.push_front(-i - 1);
+  }
+  EXPECT_EQ(deque.size(), 100000);
+  EXPECT_EQ(deque.front(), -50000);
+  EXPECT_EQ(deque.back(), 49999);
+
+  ::deque<int> copy = deque;
+  EXPECT_TRUE(copy.realtime_growth());
+  ::deque<int> moved = std::move(copy);
+  EXPECT_TRUE(moved.realtime_growth());
+  moved.pop_front_n(60000);
+  moved.pop_back_n(30000);
+  EXPECT_EQ(moved.front(), 10000);
+  EXPECT_EQ(moved.back(), 19999);
+
+  deque.set_realtime_growth(false);
+  EXPECT_FALSE(deque.realtime_growth());
+  for (int i = 0; i < 100000; ++i)
+    ASSERT_EQ(deque[i], i - 50000);
+  deque.clear();
+  moved.clear();
+  moved.push_back(1);
+  EXPECT_EQ(moved.back(), 1);
+}
+
+TEST(TieredVectorTest, MatchesVector) {
+  tiered_vector<int> tiered;
+  std::vector<int> expected;
+  unsigned x = 777;
+  for (int step = 0; step < 30000; ++step) {
+    x = x * 1103515245 + 12345;
+    unsigned op = (x >> 16) % 8;
+    size_t pos = expected.empty() ? 0 : (x >> 8) % (expected.size() + 1);
+    if (step > 20000 && op < 5)
+      op = 5;
+    if (op < 3) {
+      tiered.insert(pos, step);
+      expected.insert(expected.begin() + pos, step);
+    }
+    else if (op == 3) {
+      tiered.push_front(step);
+      expected.insert(expected.begin(), step);
+    }
+    else if (op == 4) {
+      tiered.push_back(step);
+      expected.push_back(step);
+    }
+    else if (!expected.empty()) {
+      pos %= expected.size();
+      tiered.erase(pos);
+      expected.erase(expected.begin() + pos);
+    }
+    ASSERT_EQ(tiered.size(), expected.size());
+  }
+  EXPECT_TRUE(std::equal(tiered.begin(), tiered.end(), expected.begin(), expected.end()));
+}
+
+TEST(TieredVectorTest, MatchesVectorOfStrings) {
+  tiered_vector<std::string> tiered;
+  std::vector<std::string> expected;
+  for (int i = 0; i <= 20; ++i) {
+    tiered.push_back(std::to_string(i));
+    expected.push_back(std::to_string(i));
+  }
+  tiered.insert(16, "new");
+  expected.insert(expected.begin() + 16, "new");
+  ASSERT_TRUE(std::equal(tiered.begin(), tiered.end(), expected.begin(), expected.end()));
+
+  unsigned x = 4242;
+  for (int step = 0; step < 5000; ++step) {
+    x = x * 1103515245 + 12345;
+    unsigned op = (x >> 16) % 4;
+    size_t pos = (x >> 8) % (expected.size() + 1);
+    if (op < 3 || expected.empty()) {
+      tiered.insert(pos, std::to_string(step));
+      expected.insert(expected.begin() + pos, std::to_string(step));
+    }
+    else {
+      pos %= expected.size();
+      tiered.erase(pos);
+      expected.erase(expected.begin() + pos);
+    }
+  }
+  EXPECT_TRUE(std::equal(tiered.begin(), tiered.end(), expected.begin(), expected.end()));
+}
+
+TEST(TieredVectorTest, AdaptsBlockSize) {
+  tiered_vector<std::string> tiered;
+  for (int i = 0; i < 20000; ++i)
+    tiered.push_back(std::to_string(i));
+  EXPECT_GE(tiered.block_capacity(), 64);
+  tiered.insert(10000, "x");
+  EXPECT_EQ(tiered[10000], "x");
+  EXPECT_EQ(tiered[10001], "10000");
+  EXPECT_THROW(tiered.insert(20002, "y"), std::out_of_range);
+
+  tiered_vector<std::string> copy = tiered;
+  while (tiered.size() > 10)
+    tiered.pop_front();
+  EXPECT_EQ(tiered.block_capacity(), 16);
+  EXPECT_EQ(tiered.front(), "19990");
+  EXPECT_EQ(copy.size(), 20001);
+  EXPECT_EQ(copy.back(), "19999");
+}
+
+TEST(RecordDequeTest, PushFrontPop) {
+  record_deque<64> records;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 200; ++i) {
+    std::string text(i % 37, (char)('a' + i % 26));
+    records.push_back(std::as_bytes(std::span<char const>(text.data(), text.size())));
+    expected.push_back(text);
+  }
+  std::string big(1000, 'z');
+  records.push_back(std::as_bytes(std::span<char const>(big.data(), big.size())));
+  expected.push_back(big);
+  EXPECT_EQ(records.size(), 201);
+
+  size_t k = 0;
+  records.for_each([&](std::span<std::byte const> record) {
+    EXPECT_EQ(std::string((char const*)record.data(), record.size()), expected[k++]);
+  });
+  EXPECT_EQ(k, 201);
+
+  for (size_t i = 0; i < expected.size(); ++i) {
+    std::span<std::byte const> record = records.front();
+    ASSERT_EQ(std::string((char const*)record.data(), record.size()), expected[i]);
+    records.pop_front();
+  }
+  EXPECT_TRUE(records.empty());
+  EXPECT_EQ(records.bytes(), 0);
+}
+
+TEST(RecordDequeTest, OversizedRecordIntoDrainedDeque) {
+  record_deque<64> records;
+  std::string small(8, 'a');
+  records.push_back(std::as_bytes(std::span<char const>(small.data(), small.size())));
+  records.pop_front();
+  std::string big(100, 'b');
+  records.push_back(std::as_bytes(std::span<char const>(big.data(), big.size())));
+  EXPECT_EQ(records.size(), 1);
+  EXPECT_EQ(records.block_count(), 1);
+  ASSERT_EQ(records.front().size(), 100);
+  EXPECT_EQ((char)records.front()[99], 'b');
+  records.pop_front();
+  EXPECT_TRUE(records.empty());
+  records.push_back(std::as_bytes(std::span<char const>(small.data(), small.size())));
+  EXPECT_EQ(records.front().size(), 8);
+}
+
+TEST(RecordDequeTest, ReleasesAndReusesBlocks) {
+  record_deque<256> records;
+  std::byte payload[40] = {};
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 10; ++i) {
+      payload[0] = (std::byte)i;
+      records.push_back(payload);
+    }
+    EXPECT_LE(records.block_count(), 3);
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_EQ(records.front()[0], (std::byte)i);
+      EXPECT_EQ(records.front().size(), 40);
+      records.pop_front();
+    }
+  }
+  EXPECT_EQ(records.block_count(), 1);
+
+  records.push_back(std::span<std::byte const>());
+  record_deque<256> copy = records;
+  EXPECT_EQ(copy.size(), 1);
+  EXPECT_TRUE(copy.front().empty());
+}
+
+TEST(ConcurrentDequeTest, WriterAndSnapshot) {
+  concurrent_deque<int, 4> d;
+  auto r = d.make_reader();
+  for (int i = 0; i < 100; ++i)
+    d.push_back(i);
+  for (int i = 1; i <= 50; ++i)
+    d.push_front(-i);
+  EXPECT_EQ(d.size(), 150);
+  EXPECT_EQ(d[0], -50);
+
+  {
+    auto s = r.read();
+    for (int i = 0; i < 30; ++i)
+      d.pop_front();
+    for (int i = 0; i < 30; ++i)
+      d.push_back(100 + i);
+    ASSERT_EQ(s.size(), 150);
+    for (int i = 0; i < 150; ++i)
+      ASSERT_EQ(s[i], i - 50);
+  }
+
+  auto s = r.read();
+  ASSERT_EQ(s.size(), 150);
+  EXPECT_EQ(s.front(), -20);
+  EXPECT_EQ(s.back(), 129);
+  int expected = -20;
+  s.for_each([&](int v) { EXPECT_EQ(v, expected++); });
+  EXPECT_EQ(expected, 130);
+}
+
+TEST(ConcurrentDequeTest, PopThenPushSameEnd) {
+  concurrent_deque<std::string, 2> d;
+  auto r = d.make_reader();
+  for (int i = 0; i < 10; ++i)
+    d.push_back(std::to_string(i));
+  {
+    auto s = r.read();
+    EXPECT_EQ(s.back(), "9");
+  }
+  for (int i = 0; i < 5; ++i) {
+    d.pop_back();
+    d.pop_front();
+  }
+  d.push_back("x");
+  d.push_front("y");
+  auto s = r.read();
+  ASSERT_EQ(s.size(), 2);
+  EXPECT_EQ(s[0], "y");
+  EXPECT_EQ(s[1], "x");
+}
+
+TEST(ConcurrentDequeTest, ReadersSeeConsistentSnapshots) {
+  concurrent_deque<size_t, 16> d;
+  std::atomic<bool> done{ false };
+  std::atomic<size_t> checked{ 0 };
+  std::atomic<int> started{ 0 };
+  std::vector<std::thread> readers;
+  for (int k = 0; k < 4; ++k) {
+    readers.emplace_back([&] {
+      auto r = d.make_reader();
+      bool first = true;
+      do {
+        auto s = r.read();
+        if (first) {
+          started.fetch_add(1);
+          first = false;
+        }
+        for (size_t i = 1; i < s.size(); ++i)
+          ASSERT_EQ(s[i], s[i - 1] + 1);
+        checked.fetch_add(1);
+      } while (!done.load());
+    });
+  }
+
+  // every reader has made a read before writer starts
+  while (started.load() < 4)
+    std::this_thread::yield();
+
+  size_t next = 0;
+  for (int round = 0; round < 2000; ++round) {
+    for (int i = 0; i < 50; ++i)
+      d.push_back(next++);
+    for (int i = 0; i < 45; ++i)
+      d.pop_front();
+  }
+  done.store(true);
+  for (auto& t : readers)
+    t.join();
+  EXPECT_EQ(d.size(), 2000 * 5);
+  EXPECT_EQ(d[0], next - d.size());
+  EXPECT_GT(checked.load(), 0);
+}
+
+#ifdef __linux__
+TEST(ShmDequeTest, SingleProducerAcrossFork) {
+  std::string name = "/deque_test_spsc_" + std::to_string(getpid());
+  shm_deque<int, 16> queue(name, 64, true);
+  EXPECT_EQ(queue.capacity(), 64);
+
+  int count = 20000;
+  pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    shm_deque<int, 16> producer(name);
+    for (int i = 0; i < count; ++i)
+      producer.push_back(i);
+    _exit(0);
+  }
+
+  for (int i = 0; i < count; ++i)
+    ASSERT_EQ(queue.pop(), i);
+  int status = 0;
+  waitpid(child, &status, 0);
+  EXPECT_EQ(status, 0);
+  EXPECT_EQ(queue.size(), 0);
+  shm_deque<int, 16>::unlink(name);
+}
+
+TEST(ShmDequeTest, ManyProducersAcrossFork) {
+  std::string name = "/deque_test_mpsc_" + std::to_string(getpid());
+  shm_deque<uint64_t, 8> queue(name, 32);
+
+  int producers = 3;
+  uint64_t count = 5000;
+  std::vector<pid_t> children;
+  for (int k = 0; k < producers; ++k) {
+    pid_t child = fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+      shm_deque<uint64_t, 8> producer(name);
+      for (uint64_t i = 0; i < count; ++i)
+        producer.push_back(((uint64_t)k << 32) | i);
+      _exit(0);
+    }
+    children.push_back(child);
+  }
+
+  std::vector<uint64_t> next(producers, 0);
+  for (uint64_t i = 0; i < producers * count; ++i) {
+    uint64_t value = queue.pop();
+    uint64_t k = value >> 32;
+    ASSERT_LT(k, (uint64_t)producers);
+    ASSERT_EQ(value & 0xffffffff, next[k]++);
+  }
+  for (pid_t child : children)
+    waitpid(child, nullptr, 0);
+  EXPECT_EQ(queue.size(), 0);
+  shm_deque<uint64_t, 8>::unlink(name);
+}
+
+TEST(ShmDequeTest, ReserveCommitAndRecover) {
+  std::string name = "/deque_test_recover_" + std::to_string(getpid());
+  shm_deque<int, 4> queue(name, 8);
+  using wide_queue = shm_deque<long long, 4>;
+  using small_queue = shm_deque<int, 4>;
+  EXPECT_THROW(wide_queue wrong(name), std::runtime_error);
+  EXPECT_THROW(small_queue again(name, 8), std::system_error);
+
+  auto r = queue.try_reserve();
+  ASSERT_TRUE(r);
+  *r.value = 1;
+  EXPECT_EQ(queue.front(), nullptr);
+  queue.commit(r);
+  ASSERT_NE(queue.front(), nullptr);
+  EXPECT_EQ(*queue.front(), 1);
+  queue.pop_front();
+
+  pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    shm_deque<int, 4> producer(name);
+    producer.try_reserve();
+    _exit(0);
+  }
+  waitpid(child, nullptr, 0);
+
+  queue.push_back(2);
+  EXPECT_EQ(queue.size(), 2);
+  EXPECT_EQ(queue.front(), nullptr);
+  EXPECT_EQ(queue.recover(), 1);
+  EXPECT_EQ(queue.pop(), 2);
+
+  for (int i = 0; i < 8; ++i)
+    EXPECT_TRUE(queue.try_push(i));
+  EXPECT_FALSE(queue.try_push(8));
+  int value = -1;
+  EXPECT_TRUE(queue.try_pop(value));
+  EXPECT_EQ(value, 0);
+  shm_deque<int, 4>::unlink(name);
+}
+
+TEST(ShmDequeTest, ConsumerDiesWhileReleasingSlot) {
+  std::string name = "/deque_test_consumer_" + std::to_string(getpid());
+  shm_deque<int, 16> queue(name, 512);
+  for (int i = 0; i < 300; ++i)
+    queue.push_back(i);
+
+  pid_t child = fork();
+  ASSERT_NE(child, -1);
+  if (child == 0) {
+    // header shares the first page with the first slots: consume up to a slot on another page and
+    // make the header read-only, so pop_front() frees the slot and dies moving head
+    shm_deque<int, 16> consumer(name);
+    uintptr_t page = (uintptr_t)::sysconf(_SC_PAGESIZE);
+    uintptr_t header_page = (uintptr_t)consumer.front() & ~(page - 1);
+    while (((uintptr_t)consumer.front() & ~(page - 1)) == header_page)
+      consumer.pop_front();
+    ::signal(SIGSEGV, SIG_DFL);
+    ::mprotect((void*)header_page, page, PROT_READ);
+    consumer.pop_front();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(child, &status, 0);
+  ASSERT_TRUE(WIFSIGNALED(status));
+
+  shm_deque<int, 16> consumer(name);
+  ASSERT_NE(consumer.front(), nullptr);
+  int first = *consumer.front();
+  EXPECT_GT(first, 0);
+  size_t left = consumer.size();
+  EXPECT_EQ(left, (size_t)(300 - first));
+  size_t pushed = 0;
+  while (queue.try_push(300 + (int)pushed))
+    ++pushed;
+  EXPECT_EQ(pushed, consumer.capacity() - left);
+  for (int expected = first; expected < 300 + (int)pushed; ++expected)
+    ASSERT_EQ(consumer.pop(), expected);
+  EXPECT_EQ(consumer.front(), nullptr);
+  shm_deque<int, 16>::unlink(name);
+}
+#endif
+
+TEST(DequeEraseIfTest, MatchesVector) {
+  for (int shift = 0; shift < 4; ++shift) {
+    deque<int> deque;
+    std::vector<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+      deque.push_back(i);
+      expected.push_back(i);
+    }
+    for (int i = 0; i < shift; ++i) {
+      deque.pop_front();
+      expected.erase(expected.begin());
+    }
+
+    auto pred = [](int v) { return v % 3 == 0 || (v / 50) % 2 == 1; };
+    size_t removed = deque.erase_if(pred);
+    expected.erase(std::remove_if(expected.begin(), expected.end(), pred), expected.end());
+    EXPECT_EQ(removed, 1000 - shift - expected.size());
+    ASSERT_EQ(deque.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+      ASSERT_EQ(deque[i], expected[i]);
+
+    deque.push_back(-1);
+    deque.push_front(-2);
+    EXPECT_EQ(deque.front(), -2);
+    EXPECT_EQ(deque.back(), -1);
+    EXPECT_EQ(erase_if(deque, [](int v) { return v >= -2; }), expected.size() + 2);
+    EXPECT_TRUE(deque.empty());
+  }
+}
+
+TEST(DequeEraseIfTest, NonTrivialElements) {
+  deque<std::string> deque;
+  for (int i = 0; i < 100; ++i)
+    deque.push_back(std::string(20, (char)('a' + i % 26)) + std::to_string(i));
+  EXPECT_EQ(deque.erase_if([](std::string const& v) { return v.back() != '7'; }), 90);
+  ASSERT_EQ(deque.size(), 10);
+  for (size_t i = 0; i < deque.size(); ++i)
+    EXPECT_EQ(deque[i].substr(20), std::to_string(i * 10 + 7));
+  EXPECT_EQ(deque.erase_if([](std::string const&) { return false; }), 0);
+  EXPECT_EQ(deque.size(), 10);
+}
+
+TEST(SortedDequeTest, LateArrivalsAndSearch) {
+  sorted_deque<int, std::less<int>, 8> sorted;
+  std::vector<int> expected;
+  unsigned x = 777;
+  for (int t = 0; t < 3000; ++t) {
+    x = x * 1103515245 + 12345;
+    int value = t - (int)((x >> 16) % 40);
+    size_t pos = sorted.insert(value);
+    auto it = std::upper_bound(expected.begin(), expected.end(), value);
+    EXPECT_EQ(pos, (size_t)(it - expected.begin()));
+    expected.insert(it, value);
+    if (t % 7 == 0) {
+      sorted.pop_front();
+      expected.erase(expected.begin());
+    }
+  }
+
+  ASSERT_EQ(sorted.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+    ASSERT_EQ(sorted[i], expected[i]);
+  for (int value = expected.front() - 2; value <= expected.back() + 2; ++value) {
+    ASSERT_EQ(sorted.lower_bound(value), (size_t)(std::lower_bound(expected.begin(), expected.end(), value) - expected.begin()));
+    ASSERT_EQ(sorted.upper_bound(value), (size_t)(std::upper_bound(expected.begin(), expected.end(), value) - expected.begin()));
+  }
+  EXPECT_THROW(sorted.at(sorted.size()), std::out_of_range);
+}
+
+TEST(SortedDequeTest, EvictFrontAndBack) {
+  sorted_deque<std::string, std::less<std::string>, 4> sorted;
+  for (int i = 0; i < 100; ++i)
+    sorted.push_back(std::to_string(1000 + i));
+  sorted.push_back("1050");
+  EXPECT_EQ(sorted.size(), 101);
+  EXPECT_EQ(sorted.erase_before("1050"), 50);
+  EXPECT_EQ(sorted.front(), "1050");
+  EXPECT_EQ(sorted[1], "1050");
+  EXPECT_EQ(sorted.back(), "1099");
+  for (int i = 0; i < 10; ++i)
+    sorted.pop_back();
+  EXPECT_EQ(sorted.back(), "1089");
+  std::vector<std::string> seen;
+  sorted.for_each([&](std::string const& v) { seen.push_back(v); });
+  EXPECT_EQ(seen.size(), 41);
+  EXPECT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+  EXPECT_EQ(sorted.erase_before("2000"), 41);
+  EXPECT_TRUE(sorted.empty());
+  sorted.push_back("a");
+  EXPECT_EQ(sorted.lower_bound("a"), 0);
+}
+
+TEST(DequeCompareTest, EqualityAndOrderAcrossLayouts) {
+  deque<int> a;
+  deque<int> b;
+  for (int i = 0; i < 100; ++i)
+    a.push_back(i);
+  for (int i = 99; i >= 0; --i)
+    b.push_front(i);
+  b.push_front(-1);
+  b.pop_front();
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(a <=> b, std::strong_ordering::equal);
+  EXPECT_EQ(std::hash<deque<int>>()(a), std::hash<deque<int>>()(b));
+
+  b[57] = 1000;
+  EXPECT_FALSE(a == b);
+  EXPECT_TRUE(a < b);
+  b[57] = 57;
+  b.pop_back();
+  EXPECT_TRUE(a != b);
+  EXPECT_TRUE(b < a);
+  EXPECT_NE(std::hash<deque<int>>()(a), std::hash<deque<int>>()(b));
+
+  deque<unsigned char> bytes1;
+  deque<unsigned char> bytes2;
+  for (int i = 0; i < 30; ++i) {
+    bytes1.push_back((unsigned char)i);
+    bytes2.push_back((unsigned char)i);
+  }
+  bytes2.pop_front();
+  bytes2.push_front(0);
+  EXPECT_TRUE(bytes1 == bytes2);
+  bytes2[29] = 200;
+  EXPECT_TRUE(bytes1 < bytes2);
+}
+
+TEST(DequeCompareTest, HashNonTrivialElements) {
+  deque<std::string> a;
+  deque<std::string> b;
+  for (int i = 0; i < 20; ++i) {
+    a.push_back(std::to_string(i));
+    b.push_back(std::to_string(i));
+  }
+  EXPECT_TRUE(a == b);
+  EXPECT_TRUE(a >= b);
+  EXPECT_EQ(std::hash<deque<std::string>>()(a), std::hash<deque<std::string>>()(b));
+  b[0] = "x";
+  EXPECT_TRUE(a < b);
+  EXPECT_FALSE(deque<std::string>() == a);
+  EXPECT_TRUE(deque<std::string>() < a);
+}
+
+struct ci_char {
+  char c;
+  bool operator==(ci_char other) const {
+    return std::tolower((unsigned char)c) == std::tolower((unsigned char)other.c);
+  }
+};
+
+template <>
+struct std::hash<ci_char> {
+  size_t operator()(ci_char x) const noexcept {
+    return std::hash<int>()(std::tolower((unsigned char)x.c));
+  }
+};
+
+TEST(DequeCompareTest, CustomEqualityIsUsed) {
+  deque<ci_char> a;
+  deque<ci_char> b;
+  for (char c : std::string("Deque Compare")) {
+    a.push_back(ci_char{ c });
+    b.push_back(ci_char{ (char)std::toupper((unsigned char)c) });
+  }
+  EXPECT_TRUE(a[0] == b[0]);
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(std::hash<deque<ci_char>>()(a), std::hash<deque<ci_char>>()(b));
+  b[3] = ci_char{ 'x' };
+  EXPECT_FALSE(a == b);
+}
+
+TEST(DequeSeqTest, SequenceNumbersSurvivePops) {
+  deque<int> deque;
+  EXPECT_EQ(deque.front_seq(), 0);
+  for (int i = 0; i < 100; ++i)
+    deque.push_back(i);
+  EXPECT_EQ(deque.back_seq(), 99);
+  deque.pop_front();
+  deque.pop_front_n(9);
+  EXPECT_EQ(deque.front_seq(), 10);
+  EXPECT_EQ(deque.at_seq(10), 10);
+  EXPECT_EQ(deque.at_seq(99), 99);
+  EXPECT_THROW(deque.at_seq(9), std::out_of_range);
+  EXPECT_THROW(deque.at_seq(100), std::out_of_range);
+
+  deque.push_front(-1);
+  EXPECT_EQ(deque.front_seq(), 9);
+  EXPECT_EQ(deque.at_seq(9), -1);
+  EXPECT_EQ(deque.pop_front_while([](int v) { return v < 20; }), 11);
+  EXPECT_EQ(deque.front_seq(), 20);
+
+  EXPECT_EQ(deque.pop_front_until(15), 0);
+  EXPECT_EQ(deque.pop_front_until(50), 30);
+  EXPECT_EQ(deque.front(), 50);
+  EXPECT_EQ(deque.at_seq(deque.back_seq()), 99);
+
+  ::deque<int> copy = deque;
+  EXPECT_EQ(copy.front_seq(), 50);
+  EXPECT_EQ(deque.pop_front_until(1000), 50);
+  EXPECT_TRUE(deque.empty());
+  EXPECT_EQ(deque.front_seq(), 100);
+  deque.push_back(100);
+  EXPECT_EQ(deque.at_seq(100), 100);
+
+  copy.clear();
+  EXPECT_EQ(copy.front_seq(), 100);
+  copy.set_front_seq(UINT64_MAX);
+  copy.push_back(1);
+  copy.push_back(2);
+  EXPECT_EQ(copy.at_seq(0), 2);
+  EXPECT_EQ(copy.pop_front_until(0), 1);
+  EXPECT_EQ(copy.front(), 2);
+}
+
+TEST(DequeCursorTest, UnboundCursorIsNotValid) {
+  deque<int>::cursor cursor;
+  EXPECT_FALSE(cursor.valid());
+  deque<int> deque;
+  deque.push_back(1);
+  cursor = deque.make_cursor();
+  EXPECT_TRUE(cursor.valid());
+}
+
+TEST(DequeCursorTest, SurvivesPushesAtBothEnds) {
+  for (int mode = 0; mode < 2; ++mode) {
+    deque<int> deque;
+    deque.set_realtime_growth(mode == 1);
+    for (int i = 0; i < 10; ++i)
+      deque.push_back(i);
+
+    auto it = deque.make_cursor(3);
+    auto tail = deque.make_cursor(deque.size());
+    EXPECT_FALSE(tail.valid());
+    for (int i = 1; i <= 1000; ++i) {
+      deque.push_front(-i);
+      deque.push_back(9 + i);
+      ASSERT_EQ(*it, 3);
+      ASSERT_TRUE(tail.valid());
+      ASSERT_EQ(*tail, 9 + i);
+      ++tail;
+      if (i % 100 == 0) {
+        ++it;
+        --it;
+      }
+    }
+    EXPECT_EQ(it.position(), 1003);
+
+    int expected = 3;
+    int pushed = 0;
+    for (; it.valid(); ++it) {
+      ASSERT_EQ(*it, expected <= 1009 ? expected : 0);
+      ++expected;
+      if (expected % 50 == 0) {
+        deque.push_back(0);
+        ++pushed;
+      }
+    }
+    EXPECT_EQ(expected, 1010 + pushed);
+    EXPECT_EQ(it.sequence(), deque.back_seq() + 1);
+
+    auto back = deque.cursor_at_seq(deque.back_seq());
+    for (int i = 0; i < 1500; ++i)
+      deque.pop_front();
+    EXPECT_EQ(*back, 0);
+    back += -1;
+    EXPECT_EQ(*back, 0);
+    EXPECT_TRUE(back == deque.make_cursor(deque.size() - 2));
+    deque.clear();
+    EXPECT_FALSE(back.valid());
+  }
+}
+
+TEST(MinmaxHeapTest, MatchesMultiset) {
+  minmax_heap<int> heap;
+  std::multiset<int> expected;
+  unsigned x = 4242;
+  for (int step = 0; step < 20000; ++step) {
+    x = x * 1103515245 + 12345;
+    unsigned op = (x >> 16) % 5;
+    if (op < 3 || expected.empty()) {
+      int value = (int)((x >> 8) % 1000);
+      heap.push(value);
+      expected.insert(value);
+    }
+    else if (op == 3) {
+      heap.pop_min();
+      expected.erase(expected.begin());
+    }
+    else {
+      heap.pop_max();
+      expected.erase(std::prev(expected.end()));
+    }
+    ASSERT_EQ(heap.size(), expected.size());
+    if (!expected.empty()) {
+      ASSERT_EQ(heap.min(), *expected.begin());
+      ASSERT_EQ(heap.max(), *expected.rbegin());
+    }
+  }
+}
+
+TEST(MinmaxHeapTest, BuildFromRangeAndTopK) {
+  std::vector<int> values;
+  for (int i = 0; i < 1000; ++i)
+    values.push_back((i * 7919) % 1009);
+  minmax_heap<int, std::greater<int>> heap(values.begin(), values.end());
+  EXPECT_EQ(heap.size(), 1000);
+  EXPECT_EQ(heap.min(), 1008);
+  EXPECT_EQ(heap.max(), 0);
+
+  // keep 10 largest values: the worst of them is max() in reversed order
+  minmax_heap<int> top;
+  for (int v : values) {
+    top.push(v);
+    if (top.size() > 10)
+      top.pop_min();
+  }
+  std::sort(values.rbegin(), values.rend());
+  EXPECT_EQ(top.min(), values[9]);
+  EXPECT_EQ(top.max(), values[0]);
+  std::vector<int> sorted;
+  while (!top.empty()) {
+    sorted.push_back(top.max());
+    top.pop_max();
+  }
+  EXPECT_EQ(sorted, std::vector<int>(values.begin(), values.begin() + 10));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();